@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Benchmarks run on the host build of the firmware (env:bench). Each benchmark
+ *          is a mode of the bench program:
+ * 
+ *      program dispatch <stream> [repeat]
+ *      program fixed
+ */
+namespace Bench {
+
+    /**
+     * @brief Replays a recorded command stream through setup()/loop() and reports
+     *          throughput, worst case latency and the peak stack use of the host build,
+     *          which says nothing about the AVR stack (see /stats mem for that)
+     * 
+     * @param stream file with one command per line, '#' starts a comment line
+     * @param repeat how many times the stream is replayed
+     * @return process exit code
+     */
+    int dispatch(const char *stream, unsigned int repeat);
+
+    /**
+     * @brief Compares the fixed-point conversion kernels of PH and EC against the float
+     *          reference over every ADC code and a set of calibrations and temperatures
+     * 
+     * @return process exit code, 1 if an error bound is exceeded
+     */
+    int fixedPoint();
+}
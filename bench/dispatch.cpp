@@ -0,0 +1,194 @@
+#include "Bench.h"
+
+#include <Arduino.h>
+#include <NativeHAL.h>
+
+#include <pthread.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+    const size_t STACK_SIZE = 1 << 20;
+    const uint8_t STACK_PAINT = 0xA5;
+
+    // loop() keeps running this long after the command was consumed to collect
+    // responses that are printed on later passes
+    const uint64_t QUIET_MICROS = 50000;
+
+    struct Result
+    {
+        std::string command;
+        uint64_t service = 0;       // first command byte sent to last response byte sent, us
+        uint64_t simulated = 0;     // terminator received to last response byte sent, us
+        uint64_t host = 0;          // host time of the loop() passes that read or answered the command, ns
+        size_t output = 0;          // response bytes
+    };
+
+    struct Run
+    {
+        std::vector<std::string> commands;
+        unsigned int repeat = 1;
+        std::vector<Result> results;
+        uint8_t *stackEntry = nullptr;
+    };
+
+    struct Capture
+    {
+        uint64_t last = 0;
+        size_t bytes = 0;
+    };
+
+    void capture(uint8_t c, uint64_t time, void *context)
+    {
+        Capture *out = static_cast<Capture *>(context);
+        out->last = time;
+        ++out->bytes;
+    }
+
+    void discard(uint8_t, uint64_t, void *) {}
+
+    // host time of one loop() pass, counted only if the pass touched the serial port
+    uint64_t timedLoop(const Capture &out)
+    {
+        uint64_t read = NativeHAL::bytesRead();
+        size_t written = out.bytes;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        loop();
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        NativeHAL::advance(NativeHAL::LOOP_MICROS);
+        return read != NativeHAL::bytesRead() || written != out.bytes ? elapsed : 0;
+    }
+
+    Result replay(const std::string &command)
+    {
+        Result result;
+        result.command = command;
+
+        Capture out;
+        NativeHAL::setOutputHandler(capture, &out);
+
+        std::string line = command + "\r\n";
+        uint64_t sent = NativeHAL::now();
+        NativeHAL::inject(line.data(), line.size());
+
+        while (!NativeHAL::inputDrained()) result.host += timedLoop(out);
+        uint64_t received = NativeHAL::now();
+
+        while (NativeHAL::now() - received < QUIET_MICROS) result.host += timedLoop(out);
+
+        uint64_t done = out.bytes ? max(out.last, received) : received;
+        result.service = done - sent;
+        result.simulated = done - received;
+        result.output = out.bytes;
+        return result;
+    }
+
+    void *runThread(void *arg)
+    {
+        Run *run = static_cast<Run *>(arg);
+        uint8_t entry;
+        run->stackEntry = &entry;
+
+        // steady inputs so every command takes the same path on every repetition
+        NativeHAL::setAnalog(A0, 620);
+        NativeHAL::setAnalog(A1, 300);
+        NativeHAL::setAnalog(A2, 250);
+        NativeHAL::setAnalog(A3, 307);
+        NativeHAL::setTemperature(0, 25.0f);
+
+        NativeHAL::setOutputHandler(discard, nullptr);
+        setup();
+        NativeHAL::advance(QUIET_MICROS);
+
+        for (unsigned int r = 0; r < run->repeat; ++r) {
+            for (const std::string &command : run->commands) {
+                run->results.push_back(replay(command));
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool readStream(const char *path, std::vector<std::string> &commands)
+    {
+        FILE *file = fopen(path, "r");
+        if (!file) return false;
+
+        char line[256];
+        while (fgets(line, sizeof(line), file)) {
+
+            std::string text(line);
+            while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+
+            if (text.empty() || text[0] == '#') continue;
+            commands.push_back(text);
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    size_t peakStack(const uint8_t *stack, const uint8_t *entry)
+    {
+        const uint8_t *p = stack;
+        while (p < entry && *p == STACK_PAINT) ++p;
+        return entry - p;
+    }
+}
+
+int Bench::dispatch(const char *stream, unsigned int repeat)
+{
+    Run run;
+    run.repeat = repeat ? repeat : 1;
+
+    if (!readStream(stream, run.commands) || run.commands.empty()) {
+        fprintf(stderr, "bench: cannot read commands from %s\n", stream);
+        return 1;
+    }
+
+    // the firmware runs on a painted stack so the deepest write can be found afterwards
+    std::vector<uint8_t> stack(STACK_SIZE, STACK_PAINT);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack.data(), stack.size());
+
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, runThread, &run)) {
+        fprintf(stderr, "bench: cannot start the firmware thread\n");
+        return 1;
+    }
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+
+    uint64_t service = 0, host = 0;
+    const Result *worstSimulated = &run.results[0];
+    const Result *worstHost = &run.results[0];
+
+    for (const Result &result : run.results) {
+        service += result.service;
+        host += result.host;
+        if (result.simulated > worstSimulated->simulated) worstSimulated = &result;
+        if (result.host > worstHost->host) worstHost = &result;
+    }
+
+    size_t count = run.results.size();
+    printf("stream      : %s (%zu commands x %u)\n", stream, run.commands.size(), run.repeat);
+    printf("simulated   : %.2f cmd/s, worst latency %.3f ms \"%s\"\n",
+           service ? count * 1e6 / service : 0.0,
+           worstSimulated->simulated / 1e3,
+           worstSimulated->command.c_str());
+    printf("host        : %.0f cmd/s, worst latency %.3f us \"%s\"\n",
+           host ? count * 1e9 / host : 0.0,
+           worstHost->host / 1e3,
+           worstHost->command.c_str());
+    // frames of the host compiler, not of avr-gcc, /stats mem measures the device
+    printf("host stack  : %zu bytes peak, not the AVR figure, see /stats mem\n",
+           peakStack(stack.data(), run.stackEntry));
+
+    return 0;
+}
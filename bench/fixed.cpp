@@ -0,0 +1,108 @@
+#include "Bench.h"
+
+#include <Arduino.h>
+#include <PH.h>
+#include <EC.h>
+
+#include <chrono>
+
+namespace {
+
+    // acceptance bounds, well below the resolution of one ADC count
+    const float PH_BOUND = 0.001f;
+    const float EC_BOUND = 0.001f;      // mS/cm
+
+    struct Error
+    {
+        float max = 0.0f;
+        uint16_t counts = 0;
+        uint64_t floatNanos = 0;
+        uint64_t fixedNanos = 0;
+    };
+
+    uint64_t nanosSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void checkPH(float neutral, float acid, Error &error)
+    {
+        PH ph(A3);
+        ph.setCalibration(neutral, acid);
+
+        volatile float sink = 0.0f;
+        for (uint16_t counts = 0; counts <= PH::Input::MAX_COUNTS; ++counts) {
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            float reference = ph.convert(counts);
+            error.floatNanos += nanosSince(start);
+
+            start = std::chrono::steady_clock::now();
+            float fixed = Fixed::toFloat(ph.convertFixed(counts));
+            error.fixedNanos += nanosSince(start);
+
+            sink = sink + reference + fixed;
+            if (fabs(fixed - reference) > error.max) {
+                error.max = fabs(fixed - reference);
+                error.counts = counts;
+            }
+        }
+    }
+
+    void checkEC(float low, float high, float temperature, Error &error, uint32_t &rangeMismatches)
+    {
+        EC ec(A2);
+        ec.setCalibration(low, high);
+
+        volatile float sink = 0.0f;
+        for (uint8_t range = 0; range < 2; ++range) {
+            for (uint16_t counts = 0; counts <= EC::Input::MAX_COUNTS; ++counts) {
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                float reference = ec.convert(counts, range, temperature);
+                error.floatNanos += nanosSince(start);
+
+                start = std::chrono::steady_clock::now();
+                float fixed = Fixed::toFloat(ec.convertFixed(counts, range, temperature));
+                error.fixedNanos += nanosSince(start);
+
+                sink = sink + reference + fixed;
+                if (fabs(fixed - reference) > error.max) {
+                    error.max = fabs(fixed - reference);
+                    error.counts = counts;
+                }
+
+                if (ec.selectRange(counts, range) != ec.selectRangeFixed(counts, range)) ++rangeMismatches;
+            }
+        }
+    }
+}
+
+int Bench::fixedPoint()
+{
+    const float phCalibrations[][2] = { { 1500.0f, 2032.44f }, { 1322.0f, 2210.0f }, { 1678.0f, 1854.0f } };
+    const float ecCalibrations[][2] = { { 1.0f, 1.0f }, { 0.5f, 1.5f }, { 1.5f, 0.5f } };
+    const float temperatures[] = { 0.0f, 10.0f, 25.0f, 40.0f };
+
+    Error ph;
+    for (const float *calibration : phCalibrations) checkPH(calibration[0], calibration[1], ph);
+
+    Error ec;
+    uint32_t rangeMismatches = 0;
+    for (const float *calibration : ecCalibrations) {
+        for (float temperature : temperatures) checkEC(calibration[0], calibration[1], temperature, ec, rangeMismatches);
+    }
+
+    bool pass = ph.max <= PH_BOUND && ec.max <= EC_BOUND && !rangeMismatches;
+
+    printf("ph          : max error %.6f at %u counts (bound %.4f), host float %.1f ns, fixed %.1f ns\n",
+           ph.max, ph.counts, PH_BOUND,
+           ph.floatNanos / (3.0 * (PH::Input::MAX_COUNTS + 1)), ph.fixedNanos / (3.0 * (PH::Input::MAX_COUNTS + 1)));
+    printf("ec          : max error %.6f at %u counts (bound %.4f), host float %.1f ns, fixed %.1f ns\n",
+           ec.max, ec.counts, EC_BOUND,
+           ec.floatNanos / (24.0 * (EC::Input::MAX_COUNTS + 1)), ec.fixedNanos / (24.0 * (EC::Input::MAX_COUNTS + 1)));
+    printf("ec range    : %u mismatches\n", rangeMismatches);
+    printf("result      : %s\n", pass ? "PASS" : "FAIL");
+
+    return pass ? 0 : 1;
+}
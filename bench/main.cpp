@@ -0,0 +1,20 @@
+#include "Bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && !strcmp(argv[1], "dispatch")) {
+        return Bench::dispatch(argv[2], argc >= 4 ? atoi(argv[3]) : 1);
+    }
+
+    if (argc >= 2 && !strcmp(argv[1], "fixed")) {
+        return Bench::fixedPoint();
+    }
+
+    fprintf(stderr, "usage: %s dispatch <stream> [repeat]\n"
+                    "       %s fixed\n", argv[0], argv[0]);
+    return 2;
+}
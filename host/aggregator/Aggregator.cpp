@@ -0,0 +1,484 @@
+#include "Aggregator.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+    const int MAX_EVENTS = 64;
+    const size_t READ_CHUNK = 4096;
+    const int LISTEN_BACKLOG = 64;
+
+    // consumers that send longer lines or do not read their answers are dropped
+    const size_t MAX_REQUEST = 256;
+    const size_t MAX_PENDING_OUTPUT = 1 << 20;
+
+    // names of the sample channels in the binary stream, SampleChannel in src/main.cpp
+    const char *const PACKET_CHANNELS[] = { "ph", "ec", "turb", "tds" };
+
+    int millisUntil(Aggregator::Clock::time_point when, Aggregator::Clock::time_point now)
+    {
+        if (when <= now) return 0;
+
+        // round up so epoll_wait() does not wake just before the deadline
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(when - now).count()) + 1;
+    }
+
+    /**
+     * @brief removes a socket left behind by an earlier run
+     *
+     * @return false if the path is something else than a socket (ENOTSOCK) or another
+     *          daemon still accepts on it (EADDRINUSE)
+     */
+    bool removeStale(const sockaddr_un &address)
+    {
+        struct stat status;
+        if (lstat(address.sun_path, &status)) return errno == ENOENT;
+        if (!S_ISSOCK(status.st_mode)) {
+            errno = ENOTSOCK;
+            return false;
+        }
+
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe < 0) return false;
+        bool live = connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+        ::close(probe);
+        if (live) {
+            errno = EADDRINUSE;
+            return false;
+        }
+
+        return unlink(address.sun_path) == 0 || errno == ENOENT;
+    }
+
+    void append(std::string &out, const Tester::Text &text)
+    {
+        out.append(text.data, text.size);
+    }
+}
+
+void Aggregator::Device::handle(Aggregator &aggregator, uint32_t events)
+{
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) client->readable();
+    if (client->connected() && (events & EPOLLOUT)) client->writable();
+
+    if (client->connected()) aggregator.watch(*this);
+    else aggregator.disconnect(*this, Clock::now());
+}
+
+void Aggregator::Consumer::handle(Aggregator &aggregator, uint32_t events)
+{
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        char buffer[READ_CHUNK];
+        while (true) {
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                input.append(buffer, n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+            closing = true;
+            break;
+        }
+        aggregator.serve(*this);
+    }
+
+    // drop() destroys the consumer, nothing may touch it afterwards
+    aggregator.flush(*this);
+}
+
+void Aggregator::Listener::handle(Aggregator &aggregator, uint32_t events)
+{
+    aggregator.accept();
+}
+
+Aggregator::Aggregator(const Options &options)
+    : options(options)
+{ }
+
+Aggregator::~Aggregator()
+{
+    for (const std::pair<const int, std::unique_ptr<Consumer> > &entry : consumers) ::close(entry.first);
+    consumers.clear();
+
+    if (listener.fd >= 0) {
+        ::close(listener.fd);
+        unlink(options.socket.c_str());
+    }
+    if (epoll >= 0) ::close(epoll);
+}
+
+bool Aggregator::addDevice(const std::string &name, const std::string &path)
+{
+    if (byName.count(name)) return false;
+
+    std::unique_ptr<Device> device(new Device());
+    device->name = name;
+    device->path = path;
+
+    byName[name] = device.get();
+    devices.push_back(std::move(device));
+    return true;
+}
+
+bool Aggregator::run()
+{
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0 || !listen()) return false;
+
+    // spread the polls over the interval
+    Clock::time_point now = Clock::now();
+    std::chrono::milliseconds interval(options.intervalMillis);
+    for (size_t i = 0; i < devices.size(); ++i) {
+        devices[i]->nextOpen = now;
+        devices[i]->nextPoll = now + interval * i / devices.size();
+    }
+
+    epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        tick(Clock::now());
+
+        int ready = epoll_wait(epoll, events, MAX_EVENTS, nextWake(Clock::now()));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            static_cast<Endpoint *>(events[i].data.ptr)->handle(*this, events[i].events);
+        }
+    }
+    return true;
+}
+
+bool Aggregator::listen()
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (options.socket.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    memcpy(address.sun_path, options.socket.c_str(), options.socket.size());
+
+    if (!removeStale(address)) return false;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+
+    // the listener only owns the path once bound, the destructor unlinks it
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address))) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+    listener.fd = fd;
+
+    if (::listen(listener.fd, LISTEN_BACKLOG)) return false;
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &listener;
+    return epoll_ctl(epoll, EPOLL_CTL_ADD, listener.fd, &event) == 0;
+}
+
+void Aggregator::tick(Clock::time_point now)
+{
+    for (const std::unique_ptr<Device> &device : devices) {
+        if (!device->client) {
+            if (now >= device->nextOpen) open(*device, now);
+            if (!device->client) continue;
+        }
+
+        device->client->expire();
+        if (now >= device->nextPoll) poll(*device, now);
+
+        if (device->client->connected()) watch(*device);
+        else disconnect(*device, now);
+    }
+}
+
+int Aggregator::nextWake(Clock::time_point now) const
+{
+    int wake = -1;
+
+    for (const std::unique_ptr<Device> &device : devices) {
+        int next;
+        if (device->client) {
+            next = millisUntil(device->nextPoll, now);
+            int timeout = device->client->nextTimeout();
+            if (timeout >= 0 && timeout < next) next = timeout;
+        }
+        else {
+            next = millisUntil(device->nextOpen, now);
+        }
+
+        if (wake < 0 || next < wake) wake = next;
+    }
+
+    return wake;
+}
+
+void Aggregator::open(Device &device, Clock::time_point now)
+{
+    int fd = Tester::Client::openDevice(device.path.c_str());
+    if (fd < 0) {
+        if (!device.reported) {
+            fprintf(stderr, "aggregator: %s: cannot open %s: %s\n",
+                    device.name.c_str(), device.path.c_str(), strerror(errno));
+            device.reported = true;
+        }
+        device.nextOpen = now + std::chrono::milliseconds(options.reconnectMillis);
+        return;
+    }
+
+    Device *target = &device;
+    device.client.reset(new Tester::Client(fd));
+    device.client->onPacket([this, target](const Tester::Packet &packet) {
+        if (packet.channel >= sizeof(PACKET_CHANNELS) / sizeof(PACKET_CHANNELS[0])) return;
+
+        char value[24];
+        int length = snprintf(value, sizeof(value), "%.4f", packet.value());
+        store(*target, PACKET_CHANNELS[packet.channel], Tester::Text(value, length));
+    });
+    device.client->onUnsolicited([this, target](const Tester::Text &line) {
+        // /alarm <channel> low|high|clear <sample>
+        if (line.word(0) != "/alarm" || line.word(3).empty()) return;
+
+        std::string channel = line.word(1).str();
+        store(*target, channel.c_str(), line.word(3));
+        store(*target, (channel + ".alarm").c_str(), line.word(2));
+    });
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &device;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event)) {
+        fprintf(stderr, "aggregator: %s: %s\n", device.name.c_str(), strerror(errno));
+        device.client.reset();
+        device.nextOpen = now + std::chrono::milliseconds(options.reconnectMillis);
+        return;
+    }
+
+    device.writing = false;
+    device.reported = false;
+    fprintf(stderr, "aggregator: %s: up\n", device.name.c_str());
+}
+
+void Aggregator::poll(Device &device, Clock::time_point now)
+{
+    std::chrono::milliseconds interval(options.intervalMillis);
+    device.nextPoll += interval;
+    if (device.nextPoll <= now) device.nextPoll = now + interval;
+
+    // a tester that has not answered the previous poll yet is not asked twice
+    if (device.client->pending()) return;
+
+    Device *target = &device;
+    ++device.polls;
+    device.client->send("read", [this, target](const Tester::Response &response) {
+        if (response.status != Tester::OK) {
+            ++target->failures;
+            return;
+        }
+
+        Tester::Text name;
+        Tester::Text value;
+        size_t pos = 0;
+        while ((pos = Tester::nextField(response.line(0), pos, name, value))) store(*target, name, value);
+    });
+}
+
+void Aggregator::disconnect(Device &device, Clock::time_point now)
+{
+    // before the client closes the descriptor
+    epoll_ctl(epoll, EPOLL_CTL_DEL, device.client->fd(), nullptr);
+    device.client.reset();
+
+    device.nextOpen = now + std::chrono::milliseconds(options.reconnectMillis);
+    fprintf(stderr, "aggregator: %s: down\n", device.name.c_str());
+}
+
+void Aggregator::watch(Device &device)
+{
+    bool writing = device.client->wantsWrite();
+    if (writing == device.writing) return;
+
+    epoll_event event;
+    event.events = EPOLLIN | (writing ? static_cast<uint32_t>(EPOLLOUT) : 0);
+    event.data.ptr = &device;
+    epoll_ctl(epoll, EPOLL_CTL_MOD, device.client->fd(), &event);
+    device.writing = writing;
+}
+
+void Aggregator::store(Device &device, const Tester::Text &channel, const Tester::Text &value)
+{
+    Reading &reading = device.readings[channel.str()];
+    reading.value.assign(value.data, value.size);
+    reading.updated = Clock::now();
+}
+
+void Aggregator::accept()
+{
+    while (true) {
+        int fd = accept4(listener.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fprintf(stderr, "aggregator: accept: %s\n", strerror(errno));
+            }
+            return;
+        }
+
+        std::unique_ptr<Consumer> consumer(new Consumer());
+        consumer->fd = fd;
+
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = consumer.get();
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event)) {
+            ::close(fd);
+            continue;
+        }
+
+        consumers[fd] = std::move(consumer);
+    }
+}
+
+void Aggregator::serve(Consumer &consumer)
+{
+    size_t start = 0;
+    size_t newline;
+    while ((newline = consumer.input.find('\n', start)) != std::string::npos) {
+        size_t length = newline - start;
+        if (length && consumer.input[start + length - 1] == '\r') --length;
+
+        answer(consumer, Tester::Text(consumer.input.data() + start, length));
+        start = newline + 1;
+    }
+    consumer.input.erase(0, start);
+
+    if (consumer.input.size() > MAX_REQUEST) {
+        consumer.output += "err: request too long\n";
+        consumer.closing = true;
+    }
+}
+
+void Aggregator::answer(Consumer &consumer, const Tester::Text &line)
+{
+    std::string &out = consumer.output;
+    Tester::Text command = line.word(0);
+    Clock::time_point now = Clock::now();
+
+    if (command.empty()) return;
+
+    if (command == "devices") {
+        char counts[48];
+        for (const std::unique_ptr<Device> &device : devices) {
+            snprintf(counts, sizeof(counts), " %llu %llu\n", static_cast<unsigned long long>(device->polls),
+                     static_cast<unsigned long long>(device->failures));
+            out += device->name;
+            out += ' ';
+            out += device->path;
+            out += device->client ? " up" : " down";
+            out += counts;
+        }
+        out += "end\n";
+        return;
+    }
+
+    if (command != "get") {
+        out += "err: unknown command\n";
+        return;
+    }
+
+    Tester::Text name = line.word(1);
+    Tester::Text channel = line.word(2);
+
+    std::vector<const Device *> selected;
+    if (name.empty()) {
+        for (const std::unique_ptr<Device> &device : devices) selected.push_back(device.get());
+    }
+    else {
+        std::map<std::string, Device *>::const_iterator found = byName.find(name.str());
+        if (found == byName.end()) {
+            out += "err: unknown device\n";
+            return;
+        }
+        selected.push_back(found->second);
+    }
+
+    size_t matches = 0;
+    char age[24];
+    for (const Device *device : selected) {
+        for (const std::pair<const std::string, Reading> &reading : device->readings) {
+            if (!channel.empty() && channel != Tester::Text(reading.first.data(), reading.first.size())) continue;
+
+            snprintf(age, sizeof(age), " %lld\n", static_cast<long long>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - reading.second.updated).count()));
+            out += device->name;
+            out += ' ';
+            out += reading.first;
+            out += ' ';
+            out += reading.second.value;
+            out += age;
+            ++matches;
+        }
+    }
+
+    if (!channel.empty() && !matches) {
+        out += "err: no reading of ";
+        append(out, channel);
+        out += '\n';
+        return;
+    }
+    out += "end\n";
+}
+
+void Aggregator::flush(Consumer &consumer)
+{
+    while (!consumer.output.empty()) {
+        ssize_t n = send(consumer.fd, consumer.output.data(), consumer.output.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            consumer.output.erase(0, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+        drop(consumer);
+        return;
+    }
+
+    if (consumer.output.size() > MAX_PENDING_OUTPUT || (consumer.closing && consumer.output.empty())) {
+        drop(consumer);
+        return;
+    }
+
+    bool writing = !consumer.output.empty();
+    if (writing == consumer.writing) return;
+
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | (writing ? static_cast<uint32_t>(EPOLLOUT) : 0);
+    event.data.ptr = &consumer;
+    epoll_ctl(epoll, EPOLL_CTL_MOD, consumer.fd, &event);
+    consumer.writing = writing;
+}
+
+void Aggregator::drop(Consumer &consumer)
+{
+    int fd = consumer.fd;
+    epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    consumers.erase(fd);
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <TesterClient.h>
+
+#include <signal.h>
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Daemon that owns the serial ports of many testers
+ *
+ * One epoll loop drives every port through Tester::Client and polls each tester with
+ * "/read" at a fixed interval. The devices are staggered over the interval so the
+ * loop never handles all of them at once. Values from the records, and from sample
+ * packets if a tester streams, go to a cache of the latest reading per device and
+ * channel. "/alarm" events pushed by a tester update the reading at once and set
+ * the state of the alarm as channel "<channel>.alarm" (low, high or clear).
+ * Consumers read the cache over a Unix stream socket without ever waiting for a
+ * tester.
+ *
+ * Consumer protocol, one command per line, every answer ends with a line "end":
+ *
+ *      get [device [channel]]  ->  <device> <channel> <value> <age ms>
+ *      devices                 ->  <device> <path> up|down <polls> <failures>
+ *
+ * Unknown commands, devices or channels answer "err: <reason>" instead.
+ */
+class Aggregator
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Options
+    {
+        std::string socket;
+        uint32_t intervalMillis;        // between two polls of the same device
+        uint32_t reconnectMillis;       // between two attempts to open a port
+
+        Options()
+            : socket("/tmp/tester.sock"), intervalMillis(1000), reconnectMillis(2000)
+        { }
+    };
+
+private:
+    /**
+     * @brief Anything registered with epoll, the event data points to it
+     */
+    struct Endpoint
+    {
+        virtual ~Endpoint() { }
+        virtual void handle(Aggregator &aggregator, uint32_t events) = 0;
+    };
+
+    struct Reading
+    {
+        std::string value;              // as sent by the tester
+        Clock::time_point updated;
+    };
+
+    struct Device : Endpoint
+    {
+        std::string name;
+        std::string path;
+        std::unique_ptr<Tester::Client> client;
+        bool writing = false;           // EPOLLOUT registered
+
+        Clock::time_point nextPoll;
+        Clock::time_point nextOpen;
+        uint64_t polls = 0;
+        uint64_t failures = 0;
+        bool reported = false;          // the last failure to open was logged
+
+        std::map<std::string, Reading> readings;
+
+        void handle(Aggregator &aggregator, uint32_t events) override;
+    };
+
+    struct Consumer : Endpoint
+    {
+        int fd;
+        std::string input;
+        std::string output;
+        bool writing = false;
+        bool closing = false;           // the consumer shut down its side, answer and drop
+
+        void handle(Aggregator &aggregator, uint32_t events) override;
+    };
+
+    struct Listener : Endpoint
+    {
+        int fd = -1;
+
+        void handle(Aggregator &aggregator, uint32_t events) override;
+    };
+
+    Options options;
+    int epoll = -1;
+    Listener listener;
+    volatile sig_atomic_t stopping = 0;
+
+    std::vector<std::unique_ptr<Device> > devices;
+    std::map<std::string, Device *> byName;
+    std::map<int, std::unique_ptr<Consumer> > consumers;
+
+public:
+    explicit Aggregator(const Options &options = Options());
+
+    ~Aggregator();
+
+    Aggregator(const Aggregator &) = delete;
+    Aggregator &operator=(const Aggregator &) = delete;
+
+    /**
+     * @brief adds a tester, call before run()
+     *
+     * @param name name used by consumers
+     * @param path serial port or pseudo-terminal
+     * @return false if the name is taken
+     */
+    bool addDevice(const std::string &name, const std::string &path);
+
+    /**
+     * @brief runs the event loop until stop()
+     *
+     * @return false if the socket or epoll could not be set up, errno is set
+     */
+    bool run();
+
+    /**
+     * @brief ends run() after the current pass, safe from a signal handler
+     */
+    void stop() { stopping = 1; }
+
+private:
+    bool listen();
+    void tick(Clock::time_point now);
+    int nextWake(Clock::time_point now) const;
+
+    void open(Device &device, Clock::time_point now);
+    void poll(Device &device, Clock::time_point now);
+    void disconnect(Device &device, Clock::time_point now);
+    void watch(Device &device);
+    void store(Device &device, const Tester::Text &channel, const Tester::Text &value);
+
+    void accept();
+    void serve(Consumer &consumer);
+    void answer(Consumer &consumer, const Tester::Text &line);
+    void flush(Consumer &consumer);
+    void drop(Consumer &consumer);
+};
@@ -0,0 +1,107 @@
+#include "Aggregator.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+    Aggregator *running = nullptr;
+
+    void onSignal(int)
+    {
+        if (running) running->stop();
+    }
+
+    /**
+     * @brief a port per tester plus the consumers easily exceed the default soft limit
+     *          of open files
+     */
+    void raiseFileLimit()
+    {
+        rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit)) return;
+
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int usage(const char *program)
+    {
+        fprintf(stderr, "usage: %s [--socket <path>] [--interval <ms>] [name=]<device>...\n", program);
+        return 2;
+    }
+}
+
+/**
+ * @brief Aggregator daemon, see Aggregator.h
+ *
+ *      aggregator [--socket <path>] [--interval <ms>] [name=]<device>...
+ *
+ * Devices are serial ports or pseudo-terminals of the emulator (host/emulator). A
+ * device is named after the last component of its path unless a name is given.
+ * Consumers connect to the socket, /tmp/tester.sock by default. A socket left behind
+ * by an earlier run is replaced, the aggregator refuses to start if another one still
+ * listens on it or the path is not a socket.
+ */
+int main(int argc, char **argv)
+{
+    Aggregator::Options options;
+    std::vector<std::pair<std::string, std::string> > devices;
+
+    for (int i = 1; i < argc; ++i) {
+        bool value = i + 1 < argc;
+
+        if (!strcmp(argv[i], "--socket") && value) {
+            options.socket = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--interval") && value) {
+            int interval = atoi(argv[++i]);
+            if (interval <= 0) return usage(argv[0]);
+            options.intervalMillis = interval;
+        }
+        else if (argv[i][0] != '-') {
+            std::string argument(argv[i]);
+            size_t equals = argument.find('=');
+            if (equals != std::string::npos) {
+                devices.push_back(std::make_pair(argument.substr(0, equals), argument.substr(equals + 1)));
+            }
+            else {
+                size_t slash = argument.rfind('/');
+                devices.push_back(std::make_pair(argument.substr(slash == std::string::npos ? 0 : slash + 1), argument));
+            }
+        }
+        else {
+            return usage(argv[0]);
+        }
+    }
+
+    if (devices.empty()) return usage(argv[0]);
+
+    Aggregator aggregator(options);
+    for (const std::pair<std::string, std::string> &device : devices) {
+        if (!aggregator.addDevice(device.first, device.second)) {
+            fprintf(stderr, "aggregator: duplicate device name %s\n", device.first.c_str());
+            return 2;
+        }
+    }
+
+    raiseFileLimit();
+
+    running = &aggregator;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!aggregator.run()) {
+        fprintf(stderr, "aggregator: %s: %s\n", options.socket.c_str(), strerror(errno));
+        return 1;
+    }
+    return 0;
+}
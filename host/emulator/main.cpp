@@ -0,0 +1,294 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <deque>
+#include <string>
+
+namespace {
+
+    const size_t READ_CHUNK = 256;
+
+    // longest sleep of the pacing, input is also polled while sleeping
+    const uint64_t MAX_SLEEP_MICROS = 10000;
+
+    volatile sig_atomic_t stopping = 0;
+
+    struct Options
+    {
+        const char *link = nullptr;
+        const char *eeprom = nullptr;
+        const char *script = nullptr;
+        double speed = 1.0;
+    };
+
+    // transmitted byte, held back until the wall clock reaches the time it left the UART
+    struct Byte
+    {
+        uint64_t time;
+        char c;
+    };
+
+    struct Terminal
+    {
+        int master = -1;
+        int slave = -1;         // kept open so the master does not hang up between clients
+        std::deque<Byte> scheduled;
+        std::string output;     // released, not yet written to the master
+    };
+
+    void onSignal(int)
+    {
+        stopping = 1;
+    }
+
+    void collect(uint8_t c, uint64_t time, void *context)
+    {
+        Byte byte = { time, static_cast<char>(c) };
+        static_cast<Terminal *>(context)->scheduled.push_back(byte);
+    }
+
+    uint64_t wallMicros()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i < argc; ++i) {
+            bool value = i + 1 < argc;
+
+            if (!strcmp(argv[i], "--link") && value)        options.link = argv[++i];
+            else if (!strcmp(argv[i], "--eeprom") && value) options.eeprom = argv[++i];
+            else if (!strcmp(argv[i], "--speed") && value)  options.speed = atof(argv[++i]);
+            else if (argv[i][0] != '-' && !options.script)  options.script = argv[i];
+            else return false;
+        }
+        return options.speed >= 0.0;
+    }
+
+    bool openTerminal(Terminal &terminal)
+    {
+        terminal.master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (terminal.master < 0 || grantpt(terminal.master) || unlockpt(terminal.master)) return false;
+
+        const char *path = ptsname(terminal.master);
+        if (!path) return false;
+
+        terminal.slave = open(path, O_RDWR | O_NOCTTY);
+        if (terminal.slave < 0) return false;
+
+        // no echo or line editing, the client sees the bytes of the firmware only
+        termios tty;
+        if (tcgetattr(terminal.slave, &tty)) return false;
+        cfmakeraw(&tty);
+        if (tcsetattr(terminal.slave, TCSANOW, &tty)) return false;
+
+        return fcntl(terminal.master, F_SETFL, O_NONBLOCK) == 0;
+    }
+
+    /**
+     * @brief points a symlink at the slave, replacing a link left behind by an earlier
+     *          run. Anything else at the path is refused (EEXIST)
+     */
+    bool linkSlave(const char *path, const char *target)
+    {
+        struct stat status;
+        if (!lstat(path, &status)) {
+            if (!S_ISLNK(status.st_mode)) {
+                errno = EEXIST;
+                return false;
+            }
+            if (unlink(path) && errno != ENOENT) return false;
+        }
+        else if (errno != ENOENT) {
+            return false;
+        }
+
+        return symlink(target, path) == 0;
+    }
+
+    void receive(Terminal &terminal)
+    {
+        char buffer[READ_CHUNK];
+        ssize_t n;
+        while ((n = read(terminal.master, buffer, sizeof(buffer))) > 0) {
+            NativeHAL::inject(buffer, n);
+        }
+    }
+
+    /**
+     * @brief releases the bytes that left the UART up to a simulated time
+     */
+    void release(Terminal &terminal, uint64_t until)
+    {
+        while (!terminal.scheduled.empty() && terminal.scheduled.front().time <= until) {
+            terminal.output += terminal.scheduled.front().c;
+            terminal.scheduled.pop_front();
+        }
+    }
+
+    void transmit(Terminal &terminal)
+    {
+        while (!terminal.output.empty()) {
+            ssize_t n = write(terminal.master, terminal.output.data(), terminal.output.size());
+            if (n <= 0) return;
+            terminal.output.erase(0, n);
+        }
+    }
+
+    /**
+     * @brief maps the wall clock onto the simulation for a speed factor
+     */
+    struct Pacer
+    {
+        uint64_t wallStart;
+        uint64_t simStart;
+        double speed;
+
+        uint64_t reached() const
+        {
+            return simStart + static_cast<uint64_t>((wallMicros() - wallStart) * speed);
+        }
+
+        uint64_t wallUntil(uint64_t simTime) const
+        {
+            uint64_t at = reached();
+            return simTime > at ? static_cast<uint64_t>((simTime - at) / speed) : 0;
+        }
+    };
+
+    /**
+     * @brief sleeps until the wall clock catches up with the simulation. Meanwhile
+     *          input is only queued for the next loop() and transmitted bytes are
+     *          released at the time they left the UART
+     */
+    void pace(Terminal &terminal, const Pacer &pacer)
+    {
+        for (;;) {
+            uint64_t reached = pacer.reached();
+            release(terminal, reached);
+            transmit(terminal);
+            if (stopping || reached >= NativeHAL::now()) return;
+
+            uint64_t wake = NativeHAL::now();
+            if (!terminal.scheduled.empty() && terminal.scheduled.front().time < wake) {
+                wake = terminal.scheduled.front().time;
+            }
+            uint64_t sleep = pacer.wallUntil(wake);
+            if (sleep > MAX_SLEEP_MICROS) sleep = MAX_SLEEP_MICROS;
+
+            pollfd entry;
+            entry.fd = terminal.master;
+            entry.events = POLLIN | (terminal.output.empty() ? 0 : POLLOUT);
+            entry.revents = 0;
+
+            timespec timeout;
+            timeout.tv_sec = 0;
+            timeout.tv_nsec = static_cast<long>(sleep * 1000);
+            if (ppoll(&entry, 1, &timeout, nullptr) > 0 && (entry.revents & POLLIN)) receive(terminal);
+        }
+    }
+}
+
+/**
+ * @brief Tester stand-in on a pseudo-terminal
+ *
+ * Runs the firmware on the native build (setup() once, then loop()) and connects its
+ * serial port to a pseudo-terminal, so host software talks to it like to a board on
+ * /dev/ttyACM0. The simulated clock is paced to the wall clock times the speed factor:
+ * loop() only runs again once the wall clock caught up, and every byte reaches the
+ * pseudo-terminal at the time it left the simulated 9600 baud UART. Speed 0 runs the
+ * simulation as fast as the host allows, for load tests.
+ *
+ * usage: emulator [--link <path>] [--speed <factor>] [--eeprom <file>] [script]
+ *
+ * The slave path is printed on stdout once the pseudo-terminal is ready. --link also
+ * creates a symlink to it, replacing only an existing symlink. The optional script
+ * (format in NativeHAL.h) drives the analog inputs and probes, without one the inputs
+ * are held at fixed values.
+ */
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--link <path>] [--speed <factor>] [--eeprom <file>] [script]\n", argv[0]);
+        return 2;
+    }
+
+    if (options.script) {
+        if (!NativeHAL::load(options.script)) return 1;
+    }
+    else {
+        NativeHAL::setAnalog(A0, 620);
+        NativeHAL::setAnalog(A1, 300);
+        NativeHAL::setAnalog(A2, 250);
+        NativeHAL::setAnalog(A3, 307);
+        NativeHAL::setTemperature(0, 25.0f);
+    }
+    if (options.eeprom) NativeHAL::setEepromFile(options.eeprom);
+
+    Terminal terminal;
+    if (!openTerminal(terminal)) {
+        fprintf(stderr, "emulator: cannot open a pseudo-terminal: %s\n", strerror(errno));
+        return 1;
+    }
+
+    const char *path = ptsname(terminal.master);
+    if (options.link) {
+        if (!linkSlave(options.link, path)) {
+            fprintf(stderr, "emulator: cannot link %s: %s\n", options.link, strerror(errno));
+            return 1;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("%s\n", path);
+    fflush(stdout);
+
+    NativeHAL::setOutputHandler(collect, &terminal);
+    setup();
+
+    Pacer pacer = { wallMicros(), NativeHAL::now(), options.speed };
+
+    while (!stopping && !NativeHAL::finished()) {
+        receive(terminal);
+        loop();
+        NativeHAL::advance(NativeHAL::LOOP_MICROS);
+
+        if (options.speed > 0.0) {
+            pace(terminal, pacer);
+        }
+        else {
+            release(terminal, NativeHAL::now());
+            transmit(terminal);
+        }
+    }
+
+    Serial.flush();
+    release(terminal, UINT64_MAX);
+    transmit(terminal);
+
+    if (options.link) unlink(options.link);
+    if (options.eeprom && !NativeHAL::saveEeprom()) {
+        fprintf(stderr, "emulator: cannot write %s\n", options.eeprom);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <TesterClient.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Totals
+    {
+        std::vector<uint64_t> latencies;
+        size_t statuses[Tester::CLOSED + 1] = { 0 };
+        size_t refused = 0;
+    };
+
+    bool readStream(const char *path, std::vector<std::string> &commands)
+    {
+        FILE *file = fopen(path, "r");
+        if (!file) return false;
+
+        char line[256];
+        while (fgets(line, sizeof(line), file)) {
+
+            std::string text(line);
+            while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+
+            if (text.empty() || text[0] == '#') continue;
+            commands.push_back(text);
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    double percentile(const std::vector<uint64_t> &sorted, double p)
+    {
+        if (sorted.empty()) return 0.0;
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[index] / 1e3;
+    }
+
+    void print(const Tester::Text &text, FILE *out)
+    {
+        fwrite(text.data, 1, text.size, out);
+        fputc('\n', out);
+    }
+
+    int send(Tester::Client &client, int count, char **commands)
+    {
+        int failures = 0;
+
+        for (int i = 0; i < count; ++i) {
+            bool queued = client.send(commands[i], [&failures](const Tester::Response &response) {
+                if (response.status != Tester::OK) {
+                    ++failures;
+                    fprintf(stderr, "%.*s: %s\n", static_cast<int>(response.command.size),
+                            response.command.data, Tester::statusName(response.status));
+                }
+                for (size_t j = 0; j < response.count; ++j) print(response.lines[j], stdout);
+            });
+
+            if (!queued) {
+                ++failures;
+                fprintf(stderr, "%s: refused\n", commands[i]);
+            }
+        }
+
+        client.drain();
+        return failures ? 1 : 0;
+    }
+
+    int load(Tester::Client &client, const char *stream, unsigned int repeat, size_t window)
+    {
+        std::vector<std::string> commands;
+        if (!readStream(stream, commands) || commands.empty()) {
+            fprintf(stderr, "tester: cannot read commands from %s\n", stream);
+            return 1;
+        }
+
+        Totals totals;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for (unsigned int r = 0; r < repeat; ++r) {
+            for (const std::string &command : commands) {
+                bool queued = client.send(command.c_str(), [&totals](const Tester::Response &response) {
+                    ++totals.statuses[response.status];
+                    if (response.status == Tester::OK || response.status == Tester::REJECTED) {
+                        totals.latencies.push_back(response.latencyMicros);
+                    }
+                });
+                if (!queued) ++totals.refused;
+            }
+        }
+
+        client.drain();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::sort(totals.latencies.begin(), totals.latencies.end());
+        size_t answered = totals.latencies.size();
+
+        printf("stream      : %s (%zu commands x %u)\n", stream, commands.size(), repeat);
+        printf("window      : %zu\n", window);
+        printf("throughput  : %.2f cmd/s over %.2f s\n", seconds > 0.0 ? answered / seconds : 0.0, seconds);
+        printf("latency     : p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+               percentile(totals.latencies, 0.5), percentile(totals.latencies, 0.99),
+               percentile(totals.latencies, 1.0));
+        printf("status      : %zu ok, %zu rejected, %zu timeout, %zu lost, %zu closed, %zu refused\n",
+               totals.statuses[Tester::OK], totals.statuses[Tester::REJECTED],
+               totals.statuses[Tester::TIMEOUT], totals.statuses[Tester::LOST],
+               totals.statuses[Tester::CLOSED], totals.refused);
+
+        return totals.statuses[Tester::TIMEOUT] || totals.statuses[Tester::LOST]
+            || totals.statuses[Tester::CLOSED] ? 1 : 0;
+    }
+
+    int usage(const char *program)
+    {
+        fprintf(stderr, "usage: %s <device> send <command> [command...]\n"
+                        "       %s <device> load <stream> [repeat] [window]\n", program, program);
+        return 2;
+    }
+}
+
+/**
+ * @brief Command line front end of the client library
+ *
+ *      tester <device> send <command> [command...]
+ *              sends the commands pipelined and prints the responses in order
+ *
+ *      tester <device> load <stream> [repeat] [window]
+ *              replays a command stream (bench/streams) with the given window and
+ *              reports throughput, latency and failures
+ *
+ * device is a serial port or the pseudo-terminal of the emulator (host/emulator).
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 4) return usage(argv[0]);
+
+    bool sending = !strcmp(argv[2], "send");
+    if (!sending && strcmp(argv[2], "load")) return usage(argv[0]);
+
+    Tester::Client::Options options;
+    if (!sending && argc >= 6) options.window = std::max(1, atoi(argv[5]));
+
+    int fd = Tester::Client::openDevice(argv[1]);
+    if (fd < 0) {
+        fprintf(stderr, "tester: cannot open %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    Tester::Client client(fd, options);
+    if (sending) return send(client, argc - 3, argv + 3);
+
+    unsigned int repeat = argc >= 5 ? std::max(1, atoi(argv[4])) : 1;
+    return load(client, argv[3], repeat, options.window);
+}
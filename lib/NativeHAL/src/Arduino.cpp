@@ -0,0 +1,55 @@
+#include "Arduino.h"
+#include "NativeHAL.h"
+
+namespace {
+    uint8_t digitalPins[32] = { 0 };
+}
+
+unsigned long millis()
+{
+    NativeHAL::advance(NativeHAL::CLOCK_READ_MICROS);
+    return static_cast<unsigned long>(NativeHAL::now() / 1000);
+}
+
+unsigned long micros()
+{
+    NativeHAL::advance(NativeHAL::CLOCK_READ_MICROS);
+    return static_cast<unsigned long>(NativeHAL::now());
+}
+
+void delay(unsigned long ms)
+{
+    NativeHAL::advance(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    NativeHAL::advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    // nothing to simulate
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin < sizeof(digitalPins)) digitalPins[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < sizeof(digitalPins) ? digitalPins[pin] : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+    NativeHAL::advance(NativeHAL::ANALOG_READ_MICROS);
+    return NativeHAL::sampleAnalog(pin);
+}
+
+char *dtostrf(double val, signed char width, unsigned char prec, char *sout)
+{
+    sprintf(sout, "%*.*f", width, prec, val);
+    return sout;
+}
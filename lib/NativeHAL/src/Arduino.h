@@ -0,0 +1,95 @@
+#pragma once
+
+/**
+ * @file Arduino.h
+ * @brief Host replacement of the Arduino core. Time, analog inputs, the serial port
+ *          and the 1-Wire bus are simulated by NativeHAL from a script file
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <type_traits>
+
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define NUM_ANALOG_INPUTS 6
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+// there is no flash address space on the host, PROGMEM data lives in regular memory
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+#define pgm_read_byte(addr)  (*reinterpret_cast<const uint8_t *>(addr))
+#define pgm_read_word(addr)  (*reinterpret_cast<const uint16_t *>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t *>(addr))
+#define pgm_read_float(addr) (*reinterpret_cast<const float *>(addr))
+#define pgm_read_ptr(addr)   (*(void * const *)(addr))
+
+#define memcpy_P  memcpy
+#define strcmp_P  strcmp
+#define strncmp_P strncmp
+#define strcpy_P  strcpy
+#define strlen_P  strlen
+
+#define noInterrupts()
+#define interrupts()
+
+template<class A, class B>
+inline auto min(A a, B b) -> typename std::decay<decltype(a < b ? a : b)>::type
+{
+    return a < b ? a : b;
+}
+
+template<class A, class B>
+inline auto max(A a, B b) -> typename std::decay<decltype(a < b ? a : b)>::type
+{
+    return a > b ? a : b;
+}
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+/**
+ * @brief SAM core resolution setting, the simulated ADC always reads 10 bits
+ */
+inline void analogReadResolution(int bits) { }
+
+/**
+ * @brief avr-libc float to string conversion
+ */
+char *dtostrf(double val, signed char width, unsigned char prec, char *sout);
+
+void setup();
+void loop();
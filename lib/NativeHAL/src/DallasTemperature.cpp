@@ -0,0 +1,117 @@
+#include "DallasTemperature.h"
+#include "NativeHAL.h"
+#include "Arduino.h"
+
+void DallasTemperature::begin()
+{
+    devices = NativeHAL::probeCount();
+}
+
+uint8_t DallasTemperature::getDeviceCount()
+{
+    return devices;
+}
+
+bool DallasTemperature::getAddress(uint8_t *address, uint8_t index)
+{
+    if (index >= devices) return false;
+
+    // DS18B20 family code, the probe index makes the serial number unique
+    const uint8_t rom[8] = { 0x28, index, 0x00, 0x00, 0x00, 0x00, 0x00, static_cast<uint8_t>(0xA0 ^ index) };
+    memcpy(address, rom, sizeof(rom));
+    return true;
+}
+
+bool DallasTemperature::isConnected(const uint8_t *address)
+{
+    return address[0] == 0x28 && address[1] < devices;
+}
+
+void DallasTemperature::setResolution(uint8_t bits)
+{
+    resolution = constrain(bits, 9, 12);
+}
+
+uint8_t DallasTemperature::getResolution()
+{
+    return resolution;
+}
+
+void DallasTemperature::setWaitForConversion(bool wait)
+{
+    waitForConversion = wait;
+}
+
+bool DallasTemperature::getWaitForConversion()
+{
+    return waitForConversion;
+}
+
+void DallasTemperature::requestTemperatures()
+{
+    conversionStart = millis();
+    if (waitForConversion) delay(millisToWaitForConversion(resolution));
+}
+
+bool DallasTemperature::requestTemperaturesByAddress(const uint8_t *address)
+{
+    if (!isConnected(address)) return false;
+
+    requestTemperatures();
+    return true;
+}
+
+bool DallasTemperature::requestTemperaturesByIndex(uint8_t index)
+{
+    if (index >= devices) return false;
+
+    requestTemperatures();
+    return true;
+}
+
+bool DallasTemperature::isConversionComplete()
+{
+    return millis() - conversionStart >= static_cast<unsigned long>(millisToWaitForConversion(resolution));
+}
+
+int16_t DallasTemperature::millisToWaitForConversion(uint8_t bits)
+{
+    switch (bits) {
+    case 9:  return 94;
+    case 10: return 188;
+    case 11: return 375;
+    default: return 750;
+    }
+}
+
+float DallasTemperature::getTempC(const uint8_t *address)
+{
+    return isConnected(address) ? NativeHAL::temperature(address[1]) : DEVICE_DISCONNECTED_C;
+}
+
+float DallasTemperature::getTempF(const uint8_t *address)
+{
+    float celsius = getTempC(address);
+    return celsius == DEVICE_DISCONNECTED_C ? DEVICE_DISCONNECTED_F : toFahrenheit(celsius);
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index)
+{
+    return index < devices ? NativeHAL::temperature(index) : DEVICE_DISCONNECTED_C;
+}
+
+float DallasTemperature::getTempFByIndex(uint8_t index)
+{
+    float celsius = getTempCByIndex(index);
+    return celsius == DEVICE_DISCONNECTED_C ? DEVICE_DISCONNECTED_F : toFahrenheit(celsius);
+}
+
+float DallasTemperature::toFahrenheit(float celsius)
+{
+    return celsius * 1.8f + 32.0f;
+}
+
+float DallasTemperature::toCelsius(float fahrenheit)
+{
+    return (fahrenheit - 32.0f) * 0.555555556f;
+}
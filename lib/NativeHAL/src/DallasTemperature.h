@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include "OneWire.h"
+
+#define DEVICE_DISCONNECTED_C -127
+#define DEVICE_DISCONNECTED_F -196.6
+#define DEVICE_DISCONNECTED_RAW -7040
+
+typedef uint8_t DeviceAddress[8];
+
+/**
+ * @brief Simulated DS18B20 driver with the subset of the DallasTemperature API used
+ *          by the firmware. Probe temperatures come from the temp events of the script
+ *          and a conversion takes as long as on the real part
+ */
+class DallasTemperature
+{
+private:
+    OneWire *wire = nullptr;
+    uint8_t devices = 0;
+    uint8_t resolution = 12;
+    bool waitForConversion = true;
+    unsigned long conversionStart = 0;
+
+public:
+    DallasTemperature() {}
+    DallasTemperature(OneWire *wire) : wire(wire) {}
+
+    void begin();
+
+    uint8_t getDeviceCount();
+
+    bool getAddress(uint8_t *address, uint8_t index);
+
+    bool isConnected(const uint8_t *address);
+
+    void setResolution(uint8_t bits);
+    uint8_t getResolution();
+
+    void setWaitForConversion(bool wait);
+    bool getWaitForConversion();
+
+    void requestTemperatures();
+    bool requestTemperaturesByAddress(const uint8_t *address);
+    bool requestTemperaturesByIndex(uint8_t index);
+
+    bool isConversionComplete();
+
+    int16_t millisToWaitForConversion(uint8_t bits);
+
+    float getTempC(const uint8_t *address);
+    float getTempF(const uint8_t *address);
+    float getTempCByIndex(uint8_t index);
+    float getTempFByIndex(uint8_t index);
+
+    static float toFahrenheit(float celsius);
+    static float toCelsius(float fahrenheit);
+};
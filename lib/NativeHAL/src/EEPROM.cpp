@@ -0,0 +1,24 @@
+#include "EEPROM.h"
+#include "NativeHAL.h"
+
+EEPROMClass EEPROM;
+
+uint8_t EEPROMClass::read(int address)
+{
+    return NativeHAL::eepromRead(address);
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+    NativeHAL::eepromWrite(address, value);
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+    if (read(address) != value) write(address, value);
+}
+
+uint32_t EEPROMClass::writes()
+{
+    return NativeHAL::eepromWrites();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Simulated 1 KB EEPROM of the ATmega328P. Erased bytes read 0xFF. The
+ *          contents can be loaded from and saved to a file to simulate resets, see
+ *          NativeHAL::setEepromFile()
+ */
+class EEPROMClass
+{
+public:
+    static const uint16_t SIZE = 1024;
+
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+
+    uint16_t length() { return SIZE; }
+
+    /**
+     * @brief number of bytes physically written so far
+     */
+    uint32_t writes();
+
+    template<class T>
+    T &get(int address, T &value)
+    {
+        uint8_t *bytes = reinterpret_cast<uint8_t *>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) bytes[i] = read(address + i);
+        return value;
+    }
+
+    template<class T>
+    const T &put(int address, const T &value)
+    {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) update(address + i, bytes[i]);
+        return value;
+    }
+};
+
+extern EEPROMClass EEPROM;
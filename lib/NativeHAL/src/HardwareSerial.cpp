@@ -0,0 +1,49 @@
+#include "HardwareSerial.h"
+#include "NativeHAL.h"
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    NativeHAL::serialBegin(baud);
+}
+
+void HardwareSerial::end()
+{
+    flush();
+}
+
+int HardwareSerial::available()
+{
+    return NativeHAL::serialAvailable();
+}
+
+int HardwareSerial::read()
+{
+    return NativeHAL::serialRead(true);
+}
+
+int HardwareSerial::peek()
+{
+    return NativeHAL::serialRead(false);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    NativeHAL::serialWrite(c);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) NativeHAL::serialWrite(buffer[i]);
+    return size;
+}
+
+int HardwareSerial::availableForWrite()
+{
+    return NativeHAL::serialAvailableForWrite();
+}
+
+void HardwareSerial::flush()
+{
+    NativeHAL::serialFlush();
+}
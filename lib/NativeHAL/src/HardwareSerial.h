@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Stream.h"
+
+/**
+ * @brief Simulated UART. Input bytes come from the serial events of the script and
+ *          arrive at the configured baud rate. Output goes to stdout through a 64 byte
+ *          transmit buffer that drains at the baud rate, like the AVR core does.
+ */
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud);
+    void end();
+
+    int available();
+    int read();
+    int peek();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+
+    int availableForWrite();
+
+    void flush();
+
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,448 @@
+#include "NativeHAL.h"
+#include "Arduino.h"
+#include "DallasTemperature.h"
+#include "EEPROM.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace {
+
+    enum EventType
+    {
+        EVENT_ANALOG,
+        EVENT_TEMP,
+        EVENT_SERIAL,
+        EVENT_END
+    };
+
+    struct Event
+    {
+        uint64_t time;
+        EventType type;
+        uint8_t index;
+        float value;
+        uint16_t noise;
+        std::string text;
+    };
+
+    struct PendingByte
+    {
+        uint64_t arrival;
+        uint8_t c;
+    };
+
+    const size_t RX_BUFFER_SIZE = 64;
+    const size_t TX_BUFFER_SIZE = 64;
+    const uint64_t DEFAULT_TAIL = 2000000;  // run time after the last event if there is no end event
+
+    uint64_t simClock = 0;
+    bool ended = false;
+    uint64_t endTime = UINT64_MAX;
+
+    std::vector<Event> events;
+    size_t nextEvent = 0;
+
+    uint16_t analogValues[NUM_ANALOG_INPUTS] = { 0 };
+    uint16_t analogNoise[NUM_ANALOG_INPUTS] = { 0 };
+    uint32_t noiseState = 0x12345678;
+
+    float probes[NativeHAL::MAX_PROBES];
+    uint8_t probeTotal = 0;
+
+    uint64_t byteMicros = 1042;             // 9600 baud
+    uint64_t lastArrival = 0;
+    std::deque<PendingByte> pending;
+    std::deque<uint8_t> rx;
+    uint64_t consumed = 0;
+    uint64_t txBusyUntil = 0;
+
+    uint8_t eeprom[EEPROMClass::SIZE];
+    bool eepromErased = false;
+    uint32_t eepromWriteCount = 0;
+    std::string eepromFile;
+
+    void (*interruptHandler)() = nullptr;
+    uint32_t interruptPeriod = 0;
+    uint64_t nextInterrupt = 0;
+
+    void defaultOutput(uint8_t c, uint64_t, void *)
+    {
+        fputc(c, stdout);
+    }
+
+    void (*outputHandler)(uint8_t, uint64_t, void *) = defaultOutput;
+    void *outputContext = nullptr;
+
+    uint8_t analogChannel(uint8_t pin)
+    {
+        return pin >= A0 ? pin - A0 : pin;
+    }
+
+    void queueSerial(uint64_t time, const std::string &text)
+    {
+        uint64_t t = std::max(time, lastArrival);
+        for (char c : text) {
+            t += byteMicros;
+            pending.push_back({ t, static_cast<uint8_t>(c) });
+        }
+        lastArrival = t;
+    }
+
+    void applyEvents()
+    {
+        while (nextEvent < events.size() && events[nextEvent].time <= simClock) {
+
+            const Event &event = events[nextEvent++];
+            switch (event.type) {
+            case EVENT_ANALOG:
+                NativeHAL::setAnalog(event.index, static_cast<uint16_t>(event.value), event.noise);
+                break;
+            case EVENT_TEMP:
+                NativeHAL::setTemperature(event.index, event.value);
+                break;
+            case EVENT_SERIAL:
+                queueSerial(event.time, event.text);
+                break;
+            case EVENT_END:
+                ended = true;
+                break;
+            }
+        }
+
+        if (simClock >= endTime) ended = true;
+    }
+
+    // moves bytes that arrived by now into the receive buffer, dropping them when it is full
+    void receive()
+    {
+        while (!pending.empty() && pending.front().arrival <= simClock) {
+            if (rx.size() < RX_BUFFER_SIZE - 1) rx.push_back(pending.front().c);
+            pending.pop_front();
+        }
+    }
+
+    std::string unescape(const std::string &text)
+    {
+        std::string out;
+        for (size_t i = 0; i < text.size(); ++i) {
+
+            if (text[i] != '\\' || i + 1 == text.size()) {
+                out += text[i];
+                continue;
+            }
+
+            char c = text[++i];
+            switch (c) {
+            case 'r': out += '\r'; break;
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'x':
+                out += static_cast<char>(strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+                i += 2;
+                break;
+            default:  out += c; break;
+            }
+        }
+        return out;
+    }
+
+    bool parsePin(const char *token, uint8_t &pin)
+    {
+        if (token[0] == 'A' || token[0] == 'a') {
+            pin = atoi(token + 1);
+        }
+        else {
+            pin = analogChannel(atoi(token));
+        }
+        return pin < NUM_ANALOG_INPUTS;
+    }
+
+    bool parseLine(const std::string &line, Event &event)
+    {
+        char kind[16] = { 0 };
+        unsigned long long time;
+        int consumed = 0;
+
+        if (sscanf(line.c_str(), "%llu %15s %n", &time, kind, &consumed) < 2) return false;
+
+        event.time = time * 1000;
+        event.index = 0;
+        event.value = 0.0f;
+        event.noise = 0;
+        std::string args = line.substr(consumed);
+
+        if (!strcmp(kind, "analog")) {
+            char pin[8] = { 0 };
+            unsigned int noise = 0;
+            if (sscanf(args.c_str(), "%7s %f %u", pin, &event.value, &noise) < 2) return false;
+
+            event.type = EVENT_ANALOG;
+            event.noise = noise;
+            return parsePin(pin, event.index);
+        }
+        else if (!strcmp(kind, "temp")) {
+            unsigned int probe = 0;
+            if (sscanf(args.c_str(), "%f %u", &event.value, &probe) < 1) return false;
+
+            event.type = EVENT_TEMP;
+            event.index = probe;
+            return probe < NativeHAL::MAX_PROBES;
+        }
+        else if (!strcmp(kind, "serial") || !strcmp(kind, "serialraw")) {
+            event.type = EVENT_SERIAL;
+            event.text = unescape(args);
+            if (!strcmp(kind, "serial")) event.text += "\r\n";
+            return true;
+        }
+        else if (!strcmp(kind, "end")) {
+            event.type = EVENT_END;
+            return true;
+        }
+
+        return false;
+    }
+}
+
+HardwareSerial Serial;
+
+bool NativeHAL::load(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "NativeHAL: cannot open %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    unsigned int number = 0;
+    bool hasEnd = false;
+    uint64_t last = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+
+        ++number;
+        std::string text(line);
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+
+        size_t first = text.find_first_not_of(" \t");
+        if (first == std::string::npos || text[first] == '#') continue;
+
+        Event event;
+        if (!parseLine(text, event)) {
+            fprintf(stderr, "NativeHAL: %s:%u: invalid event \"%s\"\n", path, number, text.c_str());
+            fclose(file);
+            return false;
+        }
+
+        hasEnd = hasEnd || event.type == EVENT_END;
+        last = std::max(last, event.time);
+        events.push_back(event);
+    }
+    fclose(file);
+
+    std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+        return a.time < b.time;
+    });
+
+    if (!hasEnd) endTime = last + DEFAULT_TAIL;
+
+    applyEvents();
+    return true;
+}
+
+uint64_t NativeHAL::now()
+{
+    return simClock;
+}
+
+void NativeHAL::advance(uint64_t micros)
+{
+    uint64_t target = simClock + micros;
+
+    while (interruptHandler && nextInterrupt <= target) {
+        simClock = nextInterrupt;
+        applyEvents();
+        interruptHandler();
+        nextInterrupt += interruptPeriod;
+    }
+
+    simClock = target;
+    applyEvents();
+}
+
+void NativeHAL::setPeriodicInterrupt(void (*handler)(), uint32_t periodMicros)
+{
+    interruptHandler = periodMicros ? handler : nullptr;
+    interruptPeriod = periodMicros;
+    nextInterrupt = simClock + periodMicros;
+}
+
+bool NativeHAL::finished()
+{
+    return ended;
+}
+
+void NativeHAL::setOutputHandler(void (*handler)(uint8_t, uint64_t, void *), void *context)
+{
+    outputHandler = handler ? handler : defaultOutput;
+    outputContext = context;
+}
+
+void NativeHAL::inject(const char *bytes, size_t size)
+{
+    queueSerial(simClock, std::string(bytes, size));
+}
+
+bool NativeHAL::inputDrained()
+{
+    return pending.empty() && rx.empty();
+}
+
+uint64_t NativeHAL::bytesRead()
+{
+    return consumed;
+}
+
+void NativeHAL::setAnalog(uint8_t pin, uint16_t counts, uint16_t noise)
+{
+    uint8_t channel = analogChannel(pin);
+    if (channel >= NUM_ANALOG_INPUTS) return;
+
+    analogValues[channel] = std::min<uint16_t>(counts, ADC_MAX);
+    analogNoise[channel] = noise;
+}
+
+uint16_t NativeHAL::sampleAnalog(uint8_t pin)
+{
+    uint8_t channel = analogChannel(pin);
+    if (channel >= NUM_ANALOG_INPUTS) return 0;
+
+    int32_t value = analogValues[channel];
+    if (analogNoise[channel]) {
+        // xorshift keeps the noise sequence identical between runs
+        noiseState ^= noiseState << 13;
+        noiseState ^= noiseState >> 17;
+        noiseState ^= noiseState << 5;
+        value += static_cast<int32_t>(noiseState % (2u * analogNoise[channel] + 1)) - analogNoise[channel];
+    }
+
+    return static_cast<uint16_t>(constrain(value, 0, static_cast<int32_t>(ADC_MAX)));
+}
+
+void NativeHAL::setEepromFile(const char *path)
+{
+    eepromFile = path;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return;
+
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    fread(eeprom, 1, sizeof(eeprom), file);
+    eepromErased = true;
+    fclose(file);
+}
+
+bool NativeHAL::saveEeprom()
+{
+    if (eepromFile.empty()) return false;
+
+    FILE *file = fopen(eepromFile.c_str(), "wb");
+    if (!file) return false;
+
+    bool ok = fwrite(eeprom, 1, sizeof(eeprom), file) == sizeof(eeprom);
+    fclose(file);
+    return ok;
+}
+
+uint8_t NativeHAL::eepromRead(int address)
+{
+    if (!eepromErased) {
+        memset(eeprom, 0xFF, sizeof(eeprom));
+        eepromErased = true;
+    }
+
+    return address >= 0 && address < EEPROMClass::SIZE ? eeprom[address] : 0xFF;
+}
+
+void NativeHAL::eepromWrite(int address, uint8_t value)
+{
+    eepromRead(0);      // erases the simulated EEPROM on first use
+    if (address < 0 || address >= EEPROMClass::SIZE) return;
+
+    eeprom[address] = value;
+    ++eepromWriteCount;
+}
+
+uint32_t NativeHAL::eepromWrites()
+{
+    return eepromWriteCount;
+}
+
+void NativeHAL::setTemperature(uint8_t probe, float celsius)
+{
+    if (probe >= MAX_PROBES) return;
+
+    probes[probe] = celsius;
+    if (probe >= probeTotal) probeTotal = probe + 1;
+}
+
+uint8_t NativeHAL::probeCount()
+{
+    return probeTotal;
+}
+
+float NativeHAL::temperature(uint8_t probe)
+{
+    return probe < probeTotal ? probes[probe] : DEVICE_DISCONNECTED_C;
+}
+
+void NativeHAL::serialBegin(unsigned long baud)
+{
+    if (baud) byteMicros = 10000000ull / baud;     // 8N1 frame is 10 bits
+}
+
+int NativeHAL::serialAvailable()
+{
+    receive();
+    return static_cast<int>(rx.size());
+}
+
+int NativeHAL::serialRead(bool consume)
+{
+    receive();
+    if (rx.empty()) return -1;
+
+    int c = rx.front();
+    if (consume) {
+        rx.pop_front();
+        ++consumed;
+    }
+    return c;
+}
+
+void NativeHAL::serialWrite(uint8_t c)
+{
+    // the byte waits for a free slot in the transmit buffer, like HardwareSerial::write
+    uint64_t start = std::max(simClock, txBusyUntil);
+    txBusyUntil = start + byteMicros;
+    if (txBusyUntil - simClock > TX_BUFFER_SIZE * byteMicros) {
+        advance(txBusyUntil - simClock - TX_BUFFER_SIZE * byteMicros);
+    }
+
+    outputHandler(c, txBusyUntil, outputContext);
+}
+
+int NativeHAL::serialAvailableForWrite()
+{
+    uint64_t queued = txBusyUntil > simClock ? (txBusyUntil - simClock + byteMicros - 1) / byteMicros : 0;
+    return queued < TX_BUFFER_SIZE - 1 ? static_cast<int>(TX_BUFFER_SIZE - 1 - queued) : 0;
+}
+
+void NativeHAL::serialFlush()
+{
+    if (txBusyUntil > simClock) advance(txBusyUntil - simClock);
+    fflush(stdout);
+}
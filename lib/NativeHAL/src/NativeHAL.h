@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Control interface of the simulated board. Everything runs on a virtual clock
+ *          that only moves when the firmware spends time (delay, analogRead, serial
+ *          transmission, ...) or when the runner finishes a pass of loop(), so runs are
+ *          deterministic and independent of the host speed.
+ * 
+ * Script format, one event per line, '#' starts a comment line:
+ * 
+ *      <time ms> analog <pin> <counts> [noise]   ADC value of pin from that time on
+ *      <time ms> temp <celsius> [probe]         temperature of a DS18B20 probe
+ *      <time ms> serial <text>                  sends text followed by "\r\n"
+ *      <time ms> serialraw <text>               sends text as is
+ *      <time ms> end                            stops the simulation
+ * 
+ * Serial text understands the escapes \r \n \t \\ and \xHH.
+ */
+namespace NativeHAL {
+
+    // cost model of the ATmega328P at 16 MHz, in microseconds
+    const uint32_t ANALOG_READ_MICROS = 112;
+    const uint32_t CLOCK_READ_MICROS  = 1;
+    const uint32_t LOOP_MICROS        = 4;
+
+    const uint16_t ADC_MAX            = 1023;
+    const uint8_t  MAX_PROBES         = 8;
+
+    /**
+     * @brief Loads a script file. Must be called before setup()
+     * 
+     * @param path script file
+     * @return false if the file could not be read or has an invalid line. The error
+     *          is printed to stderr
+     */
+    bool load(const char *path);
+
+    /**
+     * @brief current simulated time in microseconds
+     */
+    uint64_t now();
+
+    /**
+     * @brief moves the simulated clock forward and applies the events that became due
+     */
+    void advance(uint64_t micros);
+
+    /**
+     * @brief Simulates a periodic interrupt, e.g. the ADC conversion complete interrupt.
+     *          The handler runs whenever the clock passes a multiple of the period and
+     *          must not advance the clock itself
+     * 
+     * @param handler interrupt body, nullptr detaches it
+     * @param periodMicros time between two interrupts
+     */
+    void setPeriodicInterrupt(void (*handler)(), uint32_t periodMicros);
+
+    /**
+     * @brief true once the end of the script is reached
+     */
+    bool finished();
+
+    /**
+     * @brief Replaces the handler receiving every transmitted byte. The default handler
+     *          writes to stdout
+     * 
+     * @param handler called with the byte and the simulated time it left the UART
+     * @param context passed through to the handler
+     */
+    void setOutputHandler(void (*handler)(uint8_t c, uint64_t time, void *context), void *context);
+
+    /**
+     * @brief Queues bytes on the serial input at the current time
+     */
+    void inject(const char *bytes, size_t size);
+
+    /**
+     * @brief true if all queued serial input has been read by the firmware
+     */
+    bool inputDrained();
+
+    /**
+     * @brief number of serial bytes the firmware has read so far
+     */
+    uint64_t bytesRead();
+
+    void setAnalog(uint8_t pin, uint16_t counts, uint16_t noise = 0);
+    uint16_t sampleAnalog(uint8_t pin);
+
+    /**
+     * @brief Backs the simulated EEPROM with a file. The file is read now, if it
+     *          exists, and written by saveEeprom()
+     */
+    void setEepromFile(const char *path);
+    bool saveEeprom();
+
+    uint8_t eepromRead(int address);
+    void eepromWrite(int address, uint8_t value);
+    uint32_t eepromWrites();
+
+    void setTemperature(uint8_t probe, float celsius);
+    uint8_t probeCount();
+    float temperature(uint8_t probe);
+
+    // used by HardwareSerial
+    void serialBegin(unsigned long baud);
+    int serialAvailable();
+    int serialRead(bool consume);
+    void serialWrite(uint8_t c);
+    int serialAvailableForWrite();
+    void serialFlush();
+}
@@ -0,0 +1,40 @@
+// unit tests in test/ bring their own main()
+#if !defined(NATIVE_HAL_NO_MAIN) && !defined(PIO_UNIT_TESTING)
+
+#include "Arduino.h"
+#include "NativeHAL.h"
+
+/**
+ * @brief Runs the firmware against a script: setup() once, then loop() until the
+ *          script ends
+ * 
+ * usage: program <script> [eeprom file]
+ * 
+ * The optional EEPROM file is loaded before setup() and saved when the script ends,
+ * so consecutive runs behave like resets of the same board.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <script> [eeprom file]\n", argv[0]);
+        return 2;
+    }
+
+    if (!NativeHAL::load(argv[1])) return 1;
+    if (argc >= 3) NativeHAL::setEepromFile(argv[2]);
+
+    setup();
+    while (!NativeHAL::finished()) {
+        loop();
+        NativeHAL::advance(NativeHAL::LOOP_MICROS);
+    }
+
+    Serial.flush();
+    if (argc >= 3 && !NativeHAL::saveEeprom()) {
+        fprintf(stderr, "NativeHAL: cannot write %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
+
+#endif
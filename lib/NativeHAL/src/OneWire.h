@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Simulated 1-Wire bus. The bus itself carries no state, the probes are
+ *          modelled by DallasTemperature
+ */
+class OneWire
+{
+private:
+    uint8_t pin = 0;
+
+public:
+    OneWire() {}
+    OneWire(uint8_t pin) : pin(pin) {}
+
+    void begin(uint8_t pin) { this->pin = pin; }
+};
@@ -0,0 +1,126 @@
+#include "Print.h"
+
+#include <math.h>
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const char *str)
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write(static_cast<uint8_t>(c));
+}
+
+size_t Print::print(unsigned char n, int base)
+{
+    return print(static_cast<unsigned long>(n), base);
+}
+
+size_t Print::print(int n, int base)
+{
+    return print(static_cast<long>(n), base);
+}
+
+size_t Print::print(unsigned int n, int base)
+{
+    return print(static_cast<unsigned long>(n), base);
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == 0) return write(static_cast<uint8_t>(n));
+
+    if (base == 10 && n < 0) {
+        size_t t = print('-');
+        return printNumber(-static_cast<unsigned long>(n), 10) + t;
+    }
+
+    return printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    if (base == 0) return write(static_cast<uint8_t>(n));
+    return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+    return printFloat(n, digits);
+}
+
+size_t Print::println(const __FlashStringHelper *str) { size_t n = print(str); return n + println(); }
+size_t Print::println(const char *str)                { size_t n = print(str); return n + println(); }
+size_t Print::println(char c)                         { size_t n = print(c); return n + println(); }
+size_t Print::println(unsigned char b, int base)      { size_t n = print(b, base); return n + println(); }
+size_t Print::println(int num, int base)              { size_t n = print(num, base); return n + println(); }
+size_t Print::println(unsigned int num, int base)     { size_t n = print(num, base); return n + println(); }
+size_t Print::println(long num, int base)             { size_t n = print(num, base); return n + println(); }
+size_t Print::println(unsigned long num, int base)    { size_t n = print(num, base); return n + println(); }
+size_t Print::println(double num, int digits)         { size_t n = print(num, digits); return n + println(); }
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    *str = '\0';
+
+    if (base < 2) base = 10;
+
+    do {
+        char c = n % base;
+        n /= base;
+
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return write(str);
+}
+
+size_t Print::printFloat(double number, uint8_t digits)
+{
+    // same algorithm as the Arduino core so the simulated output matches the board
+    size_t n = 0;
+
+    if (isnan(number)) return print("nan");
+    if (isinf(number)) return print("inf");
+    if (number > 4294967040.0) return print("ovf");
+    if (number < -4294967040.0) return print("ovf");
+
+    if (number < 0.0) {
+        n += print('-');
+        number = -number;
+    }
+
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i) rounding /= 10.0;
+
+    number += rounding;
+
+    unsigned long int_part = static_cast<unsigned long>(number);
+    double remainder = number - static_cast<double>(int_part);
+    n += print(int_part);
+
+    if (digits > 0) n += print('.');
+
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int toPrint = static_cast<unsigned int>(remainder);
+        n += print(toPrint);
+        remainder -= toPrint;
+    }
+
+    return n;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class __FlashStringHelper;
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/**
+ * @brief Host replacement of the Arduino Print class. Number and float formatting
+ *          follows the Arduino core so the output matches the board byte for byte
+ */
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+
+    size_t write(const char *str)
+    {
+        return str ? write(reinterpret_cast<const uint8_t *>(str), strlen(str)) : 0;
+    }
+
+    size_t write(const char *buffer, size_t size)
+    {
+        return write(reinterpret_cast<const uint8_t *>(buffer), size);
+    }
+
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(unsigned char n, int base = DEC);
+    size_t print(int n, int base = DEC);
+    size_t print(unsigned int n, int base = DEC);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println(const __FlashStringHelper *str);
+    size_t println(const char *str);
+    size_t println(char c);
+    size_t println(unsigned char n, int base = DEC);
+    size_t println(int n, int base = DEC);
+    size_t println(unsigned int n, int base = DEC);
+    size_t println(long n, int base = DEC);
+    size_t println(unsigned long n, int base = DEC);
+    size_t println(double n, int digits = 2);
+    size_t println();
+
+private:
+    size_t printNumber(unsigned long n, uint8_t base);
+    size_t printFloat(double n, uint8_t digits);
+};
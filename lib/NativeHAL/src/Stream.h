@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Print.h"
+
+/**
+ * @brief Host replacement of the Arduino Stream class
+ */
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
@@ -0,0 +1,444 @@
+#include "TesterClient.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+    // '/' before and "\r\n" after every command
+    const size_t FRAMING_BYTES = 3;
+
+    const size_t READ_CHUNK = 4096;
+
+    // expired requests whose echo did not come for this many timeouts are given up
+    const uint32_t STALE_TIMEOUTS = 4;
+
+    speed_t baudConstant(unsigned long baud)
+    {
+        switch (baud) {
+        case 9600:   return B9600;
+        case 19200:  return B19200;
+        case 38400:  return B38400;
+        case 57600:  return B57600;
+        case 115200: return B115200;
+        default:     return B0;
+        }
+    }
+}
+
+const char *Tester::statusName(Status status)
+{
+    switch (status) {
+    case OK:       return "ok";
+    case REJECTED: return "rejected";
+    case TIMEOUT:  return "timeout";
+    case LOST:     return "lost";
+    case CLOSED:   return "closed";
+    }
+    return "?";
+}
+
+bool Tester::Response::number(float &value) const
+{
+    Text first = line(0);
+
+    size_t begin = first.size;
+    while (begin && first.data[begin - 1] != ' ') --begin;
+    return first.substr(begin).toFloat(value);
+}
+
+bool Tester::Response::field(const char *name, float &value) const
+{
+    return recordField(line(0), name, value);
+}
+
+Tester::Client::Client(int descriptor, const Options &options)
+    : descriptor(descriptor), options(options)
+{ }
+
+Tester::Client::~Client()
+{
+    close();
+    if (descriptor >= 0) ::close(descriptor);
+}
+
+int Tester::Client::openDevice(const char *path, unsigned long baud)
+{
+    speed_t speed = baudConstant(baud);
+    if (speed == B0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    termios tty;
+    if (tcgetattr(fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        cfsetispeed(&tty, speed);
+        cfsetospeed(&tty, speed);
+        tty.c_cflag |= CLOCAL | CREAD;
+        // VMIN 0 would make read() return 0 instead of EAGAIN, like end of file
+        tty.c_cc[VMIN] = 1;
+        tty.c_cc[VTIME] = 0;
+
+        if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+            int error = errno;
+            ::close(fd);
+            errno = error;
+            return -1;
+        }
+    }
+
+    return fd;
+}
+
+bool Tester::Client::send(const char *command, Callback callback)
+{
+    if (!open) return false;
+
+    Text text(command);
+    if (text.startsWith("/")) text = text.substr(1);
+    while (text.size && (text.data[text.size - 1] == ' ' || text.data[text.size - 1] == '\r'
+                         || text.data[text.size - 1] == '\n')) --text.size;
+
+    if (text.empty() || text.size > options.maxCommand) return false;
+    if (memchr(text.data, '\r', text.size) || memchr(text.data, '\n', text.size)) return false;
+
+    Request request;
+    request.command = text.str();
+    request.callback = callback;
+    request.queued = Clock::now();
+    queued.push_back(std::move(request));
+
+    fill();
+    writable();
+    return true;
+}
+
+bool Tester::Client::poll(int timeoutMillis)
+{
+    if (!open) return false;
+
+    int timeout = nextTimeout();
+    if (timeout < 0 || (timeoutMillis >= 0 && timeoutMillis < timeout)) timeout = timeoutMillis;
+
+    pollfd entry;
+    entry.fd = descriptor;
+    entry.events = POLLIN | (wantsWrite() ? POLLOUT : 0);
+    entry.revents = 0;
+
+    int ready = ::poll(&entry, 1, timeout);
+    if (ready < 0 && errno != EINTR) {
+        close();
+        return false;
+    }
+
+    if (ready > 0) {
+        if (entry.revents & (POLLIN | POLLHUP | POLLERR)) readable();
+        if (open && (entry.revents & POLLOUT)) writable();
+    }
+
+    expire();
+    return open;
+}
+
+bool Tester::Client::drain()
+{
+    while (pending()) {
+        if (!poll(-1)) return false;
+    }
+    return true;
+}
+
+bool Tester::Client::readable()
+{
+    while (open) {
+        reserve(READ_CHUNK);
+
+        ssize_t n = ::read(descriptor, input.get() + used, capacity - used);
+        if (n > 0) {
+            used += n;
+            continue;
+        }
+
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+        // end of file, or EIO once the other side of a pseudo-terminal closed
+        close();
+        break;
+    }
+
+    Frame frame;
+    size_t consumed;
+    while (parsed < used && (consumed = nextFrame(input.get() + parsed, used - parsed, frame))) {
+        parsed += consumed;
+        dispatch(frame);
+    }
+
+    compact();
+    fill();
+    return writable();
+}
+
+bool Tester::Client::writable()
+{
+    while (open && !output.empty()) {
+        ssize_t n = ::write(descriptor, output.data(), output.size());
+        if (n > 0) {
+            output.erase(0, n);
+            continue;
+        }
+
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+        close();
+    }
+    return open;
+}
+
+void Tester::Client::expire()
+{
+    Clock::time_point now = Clock::now();
+
+    if (responding && !ghost && now >= deadline(current)) {
+        complete(current, TIMEOUT, nullptr, 0);
+        ghost = true;
+        lines.clear();
+    }
+
+    // callbacks may send(), which appends to inflight
+    for (size_t i = 0; i < inflight.size(); ++i) {
+        Request &request = inflight[i];
+        if (request.expired) continue;
+        if (now < deadline(request)) break;
+
+        request.expired = true;
+        complete(request, TIMEOUT, nullptr, 0);
+    }
+
+    std::chrono::milliseconds stale(static_cast<uint64_t>(options.timeoutMillis) * STALE_TIMEOUTS);
+    while (!inflight.empty() && inflight.front().expired && now >= inflight.front().queued + stale) {
+        unechoed -= inflight.front().command.size() + FRAMING_BYTES;
+        inflight.pop_front();
+    }
+
+    while (!queued.empty() && now >= deadline(queued.front())) {
+        Request request = std::move(queued.front());
+        queued.pop_front();
+        complete(request, TIMEOUT, nullptr, 0);
+    }
+
+    fill();
+    writable();
+}
+
+int Tester::Client::nextTimeout() const
+{
+    const Request *next = nullptr;
+
+    if (responding && !ghost) {
+        next = &current;
+    }
+    else {
+        for (const Request &request : inflight) {
+            if (!request.expired) {
+                next = &request;
+                break;
+            }
+        }
+        if (!next && !queued.empty()) next = &queued.front();
+    }
+
+    if (!next) return -1;
+
+    Clock::duration left = deadline(*next) - Clock::now();
+    if (left <= Clock::duration::zero()) return 0;
+
+    // round up so poll() does not wake just before the deadline
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(left).count()) + 1;
+}
+
+size_t Tester::Client::pending() const
+{
+    size_t count = queued.size() + (responding && !ghost);
+    for (const Request &request : inflight) count += !request.expired;
+    return count;
+}
+
+void Tester::Client::fill()
+{
+    while (open && !queued.empty() && inflight.size() < options.window) {
+
+        size_t bytes = queued.front().command.size() + FRAMING_BYTES;
+        if (!inflight.empty() && unechoed + bytes > options.inputBuffer) break;
+
+        Request request = std::move(queued.front());
+        queued.pop_front();
+
+        output += '/';
+        output += request.command;
+        output += "\r\n";
+
+        request.written = Clock::now();
+        unechoed += bytes;
+        inflight.push_back(std::move(request));
+    }
+}
+
+void Tester::Client::reserve(size_t free)
+{
+    if (capacity - used >= free) return;
+
+    // lines are kept as offsets, so moving the buffer does not invalidate them
+    size_t grown = capacity * 2 > used + free ? capacity * 2 : used + free;
+    std::unique_ptr<char[]> buffer(new char[grown]);
+    if (used) memcpy(buffer.get(), input.get(), used);
+
+    input = std::move(buffer);
+    capacity = grown;
+}
+
+Tester::Client::Clock::time_point Tester::Client::deadline(const Request &request) const
+{
+    return request.queued + std::chrono::milliseconds(options.timeoutMillis);
+}
+
+void Tester::Client::dispatch(const Frame &frame)
+{
+    if (frame.kind == Frame::PACKET) {
+        if (packets) packets(frame.packet);
+        return;
+    }
+
+    Text command;
+    if (parseEcho(frame.line, command)) {
+        echo(command);
+        return;
+    }
+
+    if (!responding) {
+        if (unsolicited) unsolicited(frame.line);
+        return;
+    }
+
+    if (!ghost) lines.push_back(std::make_pair(static_cast<size_t>(frame.line.data - input.get()), frame.line.size));
+
+    if (endsResponse(Text(current.command.data(), current.command.size()), frame.line)) {
+        finishCurrent(frame.line.startsWith("/err:") ? REJECTED : OK);
+    }
+}
+
+void Tester::Client::echo(const Text &command)
+{
+    // the previous response did not end as expected, hand out what arrived
+    if (responding) finishCurrent(OK);
+
+    size_t match = 0;
+    while (match < inflight.size() && Text(inflight[match].command.data(), inflight[match].command.size()) != command) {
+        ++match;
+    }
+
+    responding = true;
+    lines.clear();
+
+    if (match == inflight.size()) {
+        // not ours or given up on, drop its response
+        ghost = true;
+        current = Request();
+        current.command = command.str();
+        return;
+    }
+
+    // the tester answers in order, the requests before it never arrived
+    for (size_t i = 0; i <= match; ++i) {
+        Request request = std::move(inflight.front());
+        inflight.pop_front();
+        unechoed -= request.command.size() + FRAMING_BYTES;
+
+        if (i < match) {
+            if (!request.expired) complete(request, LOST, nullptr, 0);
+        }
+        else {
+            ghost = request.expired;
+            current = std::move(request);
+        }
+    }
+
+    if (!hasResponse(command)) finishCurrent(OK);
+}
+
+void Tester::Client::complete(Request &request, Status status, const Text *lines, size_t count)
+{
+    if (!request.callback) return;
+
+    Response response;
+    response.status = status;
+    response.command = Text(request.command.data(), request.command.size());
+    response.lines = lines;
+    response.count = count;
+    response.latencyMicros = request.written == Clock::time_point() ? 0 :
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - request.written).count();
+
+    Callback callback = std::move(request.callback);
+    request.callback = nullptr;
+    callback(response);
+}
+
+void Tester::Client::finishCurrent(Status status)
+{
+    responding = false;
+
+    if (!ghost) {
+        texts.clear();
+        for (const std::pair<size_t, size_t> &line : lines) {
+            texts.push_back(Text(input.get() + line.first, line.second));
+        }
+        complete(current, status, texts.data(), texts.size());
+    }
+
+    ghost = false;
+    lines.clear();
+}
+
+void Tester::Client::compact()
+{
+    // lines of an incomplete response stay in place until it completes
+    size_t keep = responding && !lines.empty() ? lines.front().first : parsed;
+    if (!keep) return;
+
+    memmove(input.get(), input.get() + keep, used - keep);
+    used -= keep;
+    parsed -= keep;
+    for (std::pair<size_t, size_t> &line : lines) line.first -= keep;
+}
+
+void Tester::Client::close()
+{
+    if (!open) return;
+    open = false;
+
+    if (responding) finishCurrent(CLOSED);
+
+    while (!inflight.empty()) {
+        Request request = std::move(inflight.front());
+        inflight.pop_front();
+        if (!request.expired) complete(request, CLOSED, nullptr, 0);
+    }
+
+    while (!queued.empty()) {
+        Request request = std::move(queued.front());
+        queued.pop_front();
+        complete(request, CLOSED, nullptr, 0);
+    }
+
+    unechoed = 0;
+    output.clear();
+}
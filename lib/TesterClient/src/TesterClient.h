@@ -0,0 +1,227 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "TesterProtocol.h"
+
+/**
+ * @brief Pipelined client of one tester
+ *
+ * Requests are written as soon as the window allows instead of one round trip at a
+ * time. The tester answers in order and echoes every command before its response, so
+ * responses are matched to requests by that echo; a request whose echo never comes
+ * (the line was dropped) fails as LOST as soon as a later echo arrives.
+ *
+ * The window is bounded by the number of requests in flight and by the bytes not yet
+ * echoed, which must fit into the 64 byte receive buffer of the Uno. The echo means
+ * the line left that buffer.
+ *
+ * The client never blocks. It owns a non-blocking file descriptor (serial port or
+ * pseudo-terminal) and is driven either by poll() or, inside an event loop, by
+ * readable(), writable() and expire().
+ *
+ * Response lines are views into the read buffer and are only valid during the
+ * callback. Callbacks may send() new requests.
+ */
+namespace Tester {
+
+    enum Status : uint8_t {
+        OK,
+        REJECTED,       // the tester answered with "/err: ..."
+        TIMEOUT,
+        LOST,           // the tester never received the command
+        CLOSED          // the connection closed before the response was complete
+    };
+
+    const char *statusName(Status status);
+
+    struct Response
+    {
+        Status status;
+        Text command;               // as sent, without the leading '/'
+        const Text *lines;
+        size_t count;
+        uint64_t latencyMicros;     // from writing the command to the last line
+
+        Text line(size_t i) const { return i < count ? lines[i] : Text(); }
+
+        /**
+         * @brief last word of the first line as a number, e.g. 7.02 of "/ph 7.02"
+         */
+        bool number(float &value) const;
+
+        /**
+         * @brief field of a "/read {...}" record response
+         */
+        bool field(const char *name, float &value) const;
+    };
+
+    typedef std::function<void(const Response &)> Callback;
+    typedef std::function<void(const Text &)> LineHandler;
+    typedef std::function<void(const Packet &)> PacketHandler;
+
+    class Client
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Options
+        {
+            size_t window;                  // requests in flight
+            size_t inputBuffer;             // bytes not yet echoed, receive buffer of the tester
+            size_t maxCommand;              // LINE_SIZE of the Uno minus the terminator
+            uint32_t timeoutMillis;         // from send() to the last line
+
+            Options()
+                : window(8), inputBuffer(64), maxCommand(63), timeoutMillis(3000)
+            { }
+        };
+
+    private:
+        struct Request
+        {
+            std::string command;
+            Callback callback;
+            Clock::time_point queued;       // send()
+            Clock::time_point written;
+            bool expired = false;           // timed out, kept until its echo to stay in sync
+        };
+
+        int descriptor;
+        Options options;
+        bool open = true;
+
+        std::deque<Request> queued;         // not written yet
+        std::deque<Request> inflight;       // written, not echoed yet
+        size_t unechoed = 0;                // bytes of inflight
+
+        // request whose echo was seen last. A ghost is an echo of a request that
+        // timed out, its lines are dropped
+        bool responding = false;
+        bool ghost = false;
+        Request current;
+        std::vector<std::pair<size_t, size_t> > lines;     // offsets into input
+        std::vector<Text> texts;                            // lines handed to the callback, reused
+
+        // read buffer, grown by reserve() without clearing the new bytes
+        std::unique_ptr<char[]> input;
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t parsed = 0;
+        std::string output;
+
+        LineHandler unsolicited;
+        PacketHandler packets;
+
+    public:
+        /**
+         * @param descriptor open file descriptor, the client closes it
+         */
+        Client(int descriptor, const Options &options = Options());
+
+        ~Client();
+
+        Client(const Client &) = delete;
+        Client &operator=(const Client &) = delete;
+
+        /**
+         * @brief opens a serial port or pseudo-terminal in raw non-blocking mode
+         *
+         * @param path device, e.g. /dev/ttyACM0
+         * @param baud 9600 for the firmware
+         * @return int file descriptor, -1 on error with errno set
+         */
+        static int openDevice(const char *path, unsigned long baud = 9600);
+
+        int fd() const { return descriptor; }
+
+        bool connected() const { return open; }
+
+        /**
+         * @brief queues a command
+         *
+         * @param command command line, the leading '/' is optional
+         * @param callback called once with the response
+         * @return false if the command is too long or the connection is closed, the
+         *          callback is not called then
+         */
+        bool send(const char *command, Callback callback);
+
+        /**
+         * @brief receives lines that do not belong to a response, e.g. "/log" records
+         *          and "/alarm" events
+         */
+        void onUnsolicited(LineHandler handler) { unsolicited = handler; }
+
+        /**
+         * @brief receives the packets of the binary stream
+         */
+        void onPacket(PacketHandler handler) { packets = handler; }
+
+        /**
+         * @brief waits for the descriptor at most timeoutMillis and handles what is
+         *          ready, including timeouts
+         *
+         * @return false once the connection is closed
+         */
+        bool poll(int timeoutMillis);
+
+        /**
+         * @brief polls until every request completed
+         *
+         * @return false if the connection closed first
+         */
+        bool drain();
+
+        /**
+         * @brief reads the available input and dispatches it, for event loops
+         *
+         * @return false once the connection is closed
+         */
+        bool readable();
+
+        /**
+         * @brief writes pending commands, for event loops
+         *
+         * @return false once the connection is closed
+         */
+        bool writable();
+
+        /**
+         * @brief checks if commands are waiting for the descriptor to become writable
+         */
+        bool wantsWrite() const { return !output.empty(); }
+
+        /**
+         * @brief fails the requests that ran out of time
+         */
+        void expire();
+
+        /**
+         * @brief milliseconds until the next request times out, -1 if none is in flight
+         */
+        int nextTimeout() const;
+
+        /**
+         * @brief requests not completed yet
+         */
+        size_t pending() const;
+
+    private:
+        void reserve(size_t free);
+        void fill();
+        Clock::time_point deadline(const Request &request) const;
+        void dispatch(const Frame &frame);
+        void echo(const Text &command);
+        void complete(Request &request, Status status, const Text *lines, size_t count);
+        void finishCurrent(Status status);
+        void compact();
+        void close();
+    };
+}
@@ -0,0 +1,237 @@
+#include "TesterProtocol.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+    const char ECHO_PREFIX[] = "-> The command received: \"";
+
+    /**
+     * @brief Commands that answer with more than one line and the prefix of their last
+     *          line, kept in sync with the handlers in src/main.cpp
+     */
+    struct MultiLine
+    {
+        const char *command;
+        const char *last;
+    };
+
+    const MultiLine MULTI_LINE[] = {
+        { "ph calibrate start", "/ph calibration end" },
+        { "ec calibrate start", "/ec calibration end" },
+        { "turb help",          "/turb help" },
+        { "stats prof",         "/stats prof end" },
+        { "stats prof",         "/stats prof disabled" },
+    };
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+}
+
+Tester::Text::Text(const char *cstring)
+    : data(cstring), size(strlen(cstring))
+{ }
+
+bool Tester::Text::operator==(const Text &other) const
+{
+    return size == other.size && !memcmp(data, other.data, size);
+}
+
+bool Tester::Text::startsWith(const Text &prefix) const
+{
+    return size >= prefix.size && !memcmp(data, prefix.data, prefix.size);
+}
+
+Tester::Text Tester::Text::substr(size_t pos, size_t count) const
+{
+    if (pos > size) pos = size;
+    if (count > size - pos) count = size - pos;
+    return Text(data + pos, count);
+}
+
+Tester::Text Tester::Text::word(size_t n) const
+{
+    Text rest = after(n);
+
+    size_t length = 0;
+    while (length < rest.size && !isSpace(rest.data[length])) ++length;
+    return rest.substr(0, length);
+}
+
+Tester::Text Tester::Text::after(size_t words) const
+{
+    size_t i = 0;
+    while (i < size && isSpace(data[i])) ++i;
+
+    for (size_t n = 0; n < words; ++n) {
+        while (i < size && !isSpace(data[i])) ++i;
+        while (i < size && isSpace(data[i])) ++i;
+    }
+    return substr(i);
+}
+
+bool Tester::Text::toFloat(float &value) const
+{
+    // strtof needs a terminator, numbers are short
+    char buffer[32];
+    if (!size || size >= sizeof(buffer)) return false;
+
+    memcpy(buffer, data, size);
+    buffer[size] = '\0';
+
+    char *end;
+    value = strtof(buffer, &end);
+    return end == buffer + size;
+}
+
+bool Tester::Text::toLong(long &value) const
+{
+    char buffer[24];
+    if (!size || size >= sizeof(buffer)) return false;
+
+    memcpy(buffer, data, size);
+    buffer[size] = '\0';
+
+    char *end;
+    value = strtol(buffer, &end, 10);
+    return end == buffer + size;
+}
+
+uint8_t Tester::crc8(const uint8_t *data, size_t size)
+{
+    uint8_t crc = 0;
+    while (size--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+size_t Tester::nextFrame(const char *data, size_t size, Frame &frame)
+{
+    size_t skipped = 0;
+
+    while (skipped < size) {
+        const char *start = data + skipped;
+        size_t left = size - skipped;
+
+        // packets are only sent between lines, so a sync byte starts a frame
+        if (static_cast<uint8_t>(*start) == PACKET_SYNC) {
+            if (left < PACKET_SIZE) return 0;
+
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(start);
+            if (crc8(bytes, PACKET_SIZE - 1) != bytes[PACKET_SIZE - 1]) {
+                ++skipped;
+                continue;
+            }
+
+            frame.kind = Frame::PACKET;
+            frame.packet.channel = bytes[1];
+            frame.packet.sequence = bytes[2];
+            frame.packet.raw = static_cast<int32_t>(static_cast<uint32_t>(bytes[3])
+                                                  | static_cast<uint32_t>(bytes[4]) << 8
+                                                  | static_cast<uint32_t>(bytes[5]) << 16
+                                                  | static_cast<uint32_t>(bytes[6]) << 24);
+            return skipped + PACKET_SIZE;
+        }
+
+        // empty lines and the '\r' of "\r\n" are no frames
+        if (*start == '\r' || *start == '\n') {
+            ++skipped;
+            continue;
+        }
+
+        const char *newline = static_cast<const char *>(memchr(start, '\n', left < MAX_LINE ? left : MAX_LINE));
+        size_t length;
+        size_t consumed;
+        if (newline) {
+            length = newline - start;
+            consumed = length + 1;
+        }
+        else if (left >= MAX_LINE) {
+            length = MAX_LINE;
+            consumed = MAX_LINE;
+        }
+        else {
+            return 0;
+        }
+
+        while (length && start[length - 1] == '\r') --length;
+
+        frame.kind = Frame::LINE;
+        frame.line = Text(start, length);
+        return skipped + consumed;
+    }
+
+    return 0;
+}
+
+bool Tester::parseEcho(const Text &line, Text &command)
+{
+    Text prefix(ECHO_PREFIX, sizeof(ECHO_PREFIX) - 1);
+    if (!line.startsWith(prefix) || line.size == prefix.size || line.data[line.size - 1] != '"') {
+        return false;
+    }
+
+    command = line.substr(prefix.size, line.size - prefix.size - 1);
+    return true;
+}
+
+bool Tester::hasResponse(const Text &command)
+{
+    return command != "flush";
+}
+
+bool Tester::endsResponse(const Text &command, const Text &line)
+{
+    if (line.startsWith("/err:")) return true;
+
+    bool multiLine = false;
+    for (const MultiLine &entry : MULTI_LINE) {
+        if (command != entry.command) continue;
+        if (line.startsWith(entry.last)) return true;
+        multiLine = true;
+    }
+
+    return !multiLine;
+}
+
+size_t Tester::nextField(const Text &record, size_t pos, Text &name, Text &value)
+{
+    // "name": value, "name": value}
+    const char *open = static_cast<const char *>(memchr(record.data + pos, '"', record.size - pos));
+    if (!open) return 0;
+
+    size_t begin = open - record.data + 1;
+    const char *close = static_cast<const char *>(memchr(record.data + begin, '"', record.size - begin));
+    if (!close) return 0;
+
+    size_t end = close - record.data;
+    if (end + 1 >= record.size || record.data[end + 1] != ':') return 0;
+    name = record.substr(begin, end - begin);
+
+    begin = end + 2;
+    while (begin < record.size && isSpace(record.data[begin])) ++begin;
+
+    end = begin;
+    while (end < record.size && record.data[end] != ',' && record.data[end] != '}') ++end;
+    value = record.substr(begin, end - begin);
+
+    return end;
+}
+
+bool Tester::recordField(const Text &record, const Text &name, float &value)
+{
+    Text field;
+    Text text;
+    size_t pos = 0;
+    while ((pos = nextField(record, pos, field, text))) {
+        if (field == name) return text.toFloat(value);
+    }
+    return false;
+}
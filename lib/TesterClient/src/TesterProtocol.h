@@ -0,0 +1,164 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+/**
+ * @brief Framing of the serial protocol implemented in src/main.cpp, host side
+ *
+ * The tester sends text lines terminated by "\r\n" (the command echo only ends with
+ * "\n") and, while a binary stream is active, 8 byte sample packets between lines
+ * (src/BinaryStream.h). Every command line is acknowledged with
+ *
+ *      -> The command received: "<command>"
+ *
+ * followed by the lines of its response, all printed in the same pass of loop().
+ * Failed commands answer with a single "/err: ..." line.
+ *
+ * Nothing here copies the input: lines are handed out as Text views into the read
+ * buffer.
+ */
+namespace Tester {
+
+    const uint8_t PACKET_SYNC = 0xA5;
+    const uint8_t PACKET_SIZE = 8;
+
+    // longer runs without a newline are handed out as a line of their own
+    const size_t MAX_LINE = 512;
+
+    /**
+     * @brief Non-owning view of characters in a buffer. Only valid as long as the
+     *          buffer is, for responses until the callback returns
+     */
+    struct Text
+    {
+        const char *data = nullptr;
+        size_t size = 0;
+
+        Text() { }
+
+        Text(const char *data, size_t size)
+            : data(data), size(size)
+        { }
+
+        Text(const char *cstring);
+
+        bool empty() const { return !size; }
+
+        const char *begin() const { return data; }
+        const char *end() const { return data + size; }
+
+        bool operator==(const Text &other) const;
+        bool operator!=(const Text &other) const { return !(*this == other); }
+
+        bool startsWith(const Text &prefix) const;
+
+        /**
+         * @brief part of the text, clamped to its end
+         */
+        Text substr(size_t pos, size_t count = SIZE_MAX) const;
+
+        /**
+         * @brief n-th word separated by spaces, empty if there are fewer words
+         */
+        Text word(size_t n) const;
+
+        /**
+         * @brief the text after the first n words and the spaces that follow them
+         */
+        Text after(size_t words) const;
+
+        /**
+         * @brief parses the whole text as a number. "nan" and "inf" are numbers, the
+         *          "ovf" marker of the firmware is not
+         */
+        bool toFloat(float &value) const;
+
+        bool toLong(long &value) const;
+
+        std::string str() const { return std::string(data, size); }
+    };
+
+    /**
+     * @brief Decoded sample packet of the binary stream
+     */
+    struct Packet
+    {
+        uint8_t channel;
+        uint8_t sequence;
+        int32_t raw;            // Q16.16
+
+        float value() const { return raw / 65536.0f; }
+    };
+
+    /**
+     * @brief One unit of the input, a text line or a sample packet
+     */
+    struct Frame
+    {
+        enum Kind : uint8_t {
+            LINE,
+            PACKET
+        };
+
+        Kind kind;
+        Text line;              // without the terminator
+        Packet packet;
+    };
+
+    /**
+     * @brief CRC-8 with polynomial 0x07, as Utils::crc8 of the firmware
+     */
+    uint8_t crc8(const uint8_t *data, size_t size);
+
+    /**
+     * @brief Cuts the next frame off the front of the input. Bytes that belong to
+     *          neither a line nor a valid packet are skipped
+     *
+     * @param data unparsed input
+     * @param size bytes of input
+     * @param frame receives the frame, its line points into data
+     * @return size_t bytes consumed, 0 if the input ends inside a frame
+     */
+    size_t nextFrame(const char *data, size_t size, Frame &frame);
+
+    /**
+     * @brief extracts the command from its echo line
+     *
+     * @return false if the line is not a command echo
+     */
+    bool parseEcho(const Text &line, Text &command);
+
+    /**
+     * @brief checks if the command answers at all, "/flush" does not
+     */
+    bool hasResponse(const Text &command);
+
+    /**
+     * @brief checks if line is the last line of the response to command. Most commands
+     *          answer with one line, the others are listed in TesterProtocol.cpp
+     */
+    bool endsResponse(const Text &command, const Text &line);
+
+    /**
+     * @brief iterates the fields of a "/read {...}" record
+     *
+     * @param record the record line
+     * @param pos 0 for the first field, else the return value of the previous call
+     * @param name receives the field name without quotes
+     * @param value receives the value as sent
+     * @return size_t position after the field, 0 if there is none
+     */
+    size_t nextField(const Text &record, size_t pos, Text &name, Text &value);
+
+    /**
+     * @brief finds a field of a "/read {...}" record
+     *
+     * @param record the record line
+     * @param name field name, e.g. "ph" or "temp1"
+     * @param value receives the value
+     * @return false if there is no such field or it is not a number
+     */
+    bool recordField(const Text &record, const Text &name, float &value);
+}
@@ -0,0 +1,92 @@
+"""
+Memory report per translation unit.
+
+For every object file of the build it lists flash (.text), initialized RAM (.data),
+zeroed RAM (.bss) and the largest stack frame with its function, taken from the
+.su files written by -fstack-usage. Frames are per function, so the deepest call
+chain still has to be added up, the runtime counterpart is /stats mem.
+
+PlatformIO runs it after linking through extra_scripts (see platformio.ini), it also
+works on an existing build directory:
+
+    python3 scripts/memory_report.py .pio/build/Uno [size tool]
+"""
+
+import os
+import subprocess
+import sys
+
+
+def stack_usage(su_path):
+    """Returns (bytes, function) of the largest frame in a .su file."""
+    largest = (0, "")
+    if not os.path.exists(su_path):
+        return largest
+
+    with open(su_path) as su:
+        for line in su:
+            fields = line.rstrip("\n").split("\t")
+            if len(fields) < 2:
+                continue
+            function = fields[0].split(":", 3)[-1]      # file:line:column:function
+            size = int(fields[1])
+            if size > largest[0]:
+                largest = (size, function)
+    return largest
+
+
+def collect(build_dir, size_tool):
+    rows = []
+    for root, _, files in os.walk(build_dir):
+        for name in sorted(files):
+            if not name.endswith(".o"):
+                continue
+
+            path = os.path.join(root, name)
+            result = subprocess.run([size_tool, path], stdout=subprocess.PIPE,
+                                    stderr=subprocess.PIPE, universal_newlines=True)
+            lines = result.stdout.splitlines()
+            if result.returncode or len(lines) < 2:
+                continue
+
+            # Berkeley format: text data bss dec hex filename
+            text, data, bss = (int(field) for field in lines[1].split()[:3])
+            frame, function = stack_usage(path[:-2] + ".su")
+            rows.append((os.path.relpath(path, build_dir)[:-2], text, data, bss, frame, function))
+    return rows
+
+
+def report(build_dir, size_tool="size"):
+    rows = collect(build_dir, size_tool)
+    if not rows:
+        print("memory report: no object files in %s" % build_dir)
+        return
+
+    rows.sort(key=lambda row: (row[2] + row[3], row[1]), reverse=True)
+    width = max(len(row[0]) for row in rows)
+
+    print()
+    print("%-*s %8s %6s %6s %6s  %s" % (width, "translation unit", "flash", "data", "bss", "frame", "largest frame"))
+    for unit, text, data, bss, frame, function in rows:
+        print("%-*s %8d %6d %6d %6d  %s" % (width, unit, text, data, bss, frame, function[:60]))
+    print("%-*s %8d %6d %6d" % (width, "total (before linking)",
+                                sum(row[1] for row in rows),
+                                sum(row[2] for row in rows),
+                                sum(row[3] for row in rows)))
+
+
+try:
+    Import("env")   # noqa: F821, provided by PlatformIO
+
+    env.Append(CCFLAGS=["-fstack-usage"])  # noqa: F821
+
+    def after_link(target, source, env):
+        report(env.subst("$BUILD_DIR"), env.subst("$SIZETOOL") or "size")
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}$PROGSUFFIX", after_link)  # noqa: F821
+
+except NameError:
+    if __name__ == "__main__":
+        if len(sys.argv) < 2:
+            sys.exit("usage: %s <build dir> [size tool]" % sys.argv[0])
+        report(sys.argv[1], sys.argv[2] if len(sys.argv) > 2 else "size")
@@ -0,0 +1,160 @@
+#include "AdcCapture.h"
+#include "utils.h"
+
+#ifdef USE_ADC_CAPTURE
+
+#include <Arduino.h>
+#ifdef NATIVE
+#include <NativeHAL.h>
+#endif
+
+namespace {
+
+    uint8_t pins[AdcCapture::MAX_CHANNELS];
+    uint8_t channels = 0;
+
+    // running sums, only the interrupt adds and only take() resets
+    volatile uint16_t sums[AdcCapture::MAX_CHANNELS];
+    volatile uint8_t counts[AdcCapture::MAX_CHANNELS];
+
+    // slot 2 * i settles channel i, slot 2 * i + 1 captures it
+    volatile uint8_t slot = 0;
+    bool active = false;
+
+    inline uint8_t nextSlot(uint8_t s)
+    {
+        return s + 1 == 2 * channels ? 0 : s + 1;
+    }
+
+    inline uint8_t channelOf(uint8_t pin)
+    {
+        return pin >= A0 ? pin - A0 : pin;
+    }
+
+    // index in the channel list, channels if the pin is not captured
+    inline uint8_t indexOf(uint8_t pin)
+    {
+        uint8_t i = 0;
+        while (i < channels && channelOf(pins[i]) != channelOf(pin)) ++i;
+        return i;
+    }
+
+#ifdef __AVR__
+    inline void selectMux(uint8_t s)
+    {
+        // AVcc reference, same as analogRead() with the DEFAULT reference
+        ADMUX = _BV(REFS0) | (channelOf(pins[s >> 1]) & 0x07);
+    }
+#elif defined(NATIVE)
+    inline void selectMux(uint8_t s) { }
+
+    void simulatedInterrupt()
+    {
+        AdcCapture::onConversion(NativeHAL::sampleAnalog(pins[slot >> 1]));
+    }
+#endif
+}
+
+#ifdef __AVR__
+ISR(ADC_vect)
+{
+    AdcCapture::onConversion(ADC);
+}
+#endif
+
+void AdcCapture::begin(const uint8_t *pinList, uint8_t count)
+{
+    end();
+
+    channels = count > MAX_CHANNELS ? static_cast<uint8_t>(MAX_CHANNELS) : count;
+    for (uint8_t i = 0; i < channels; ++i) {
+        pins[i] = pinList[i];
+        sums[i] = 0;
+        counts[i] = 0;
+    }
+    if (!channels) return;
+
+    slot = 0;
+    active = true;
+
+#ifdef __AVR__
+    noInterrupts();
+    selectMux(0);
+    ADCSRB = 0;                                                         // free-running trigger
+    ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE)
+           | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0) | _BV(ADSC);           // prescaler 128, start
+    selectMux(nextSlot(0));                                             // latched by the second conversion
+    interrupts();
+#elif defined(NATIVE)
+    NativeHAL::setPeriodicInterrupt(simulatedInterrupt, CONVERSION_MICROS);
+#endif
+}
+
+void AdcCapture::end()
+{
+    if (!active) return;
+
+#ifdef __AVR__
+    // back to the single conversion setup of the Arduino core
+    ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+#elif defined(NATIVE)
+    NativeHAL::setPeriodicInterrupt(nullptr, 0);
+#endif
+
+    active = false;
+}
+
+bool AdcCapture::running()
+{
+    return active;
+}
+
+bool AdcCapture::captures(uint8_t pin)
+{
+    return indexOf(pin) < channels;
+}
+
+uint8_t AdcCapture::available(uint8_t pin)
+{
+    uint8_t i = indexOf(pin);
+    return i < channels ? counts[i] : 0;
+}
+
+bool AdcCapture::take(uint8_t pin, uint16_t &sum, uint8_t &count)
+{
+    uint8_t i = indexOf(pin);
+    if (i >= channels) return false;
+
+    noInterrupts();
+    sum = sums[i];
+    count = counts[i];
+    sums[i] = 0;
+    counts[i] = 0;
+    interrupts();
+
+    return count != 0;
+}
+
+void AdcCapture::onConversion(uint16_t value)
+{
+    uint8_t s = slot;
+
+    if (s & 1) {
+        uint8_t i = s >> 1;
+        uint16_t sum = sums[i];
+        uint8_t count = counts[i];
+
+        if (count == WINDOW) {
+            sum >>= 1;
+            count >>= 1;
+        }
+        sums[i] = sum + value;
+        counts[i] = count + 1;
+    }
+
+    s = nextSlot(s);
+    slot = s;
+    selectMux(nextSlot(s));
+}
+
+#endif
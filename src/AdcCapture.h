@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include "Board.h"
+
+/**
+ * @brief Interrupt driven multi-channel ADC capture
+ * 
+ * The ADC runs in free-running mode and the ADC interrupt walks through the channel
+ * list. Every channel is converted twice in a row: the first conversion after the
+ * multiplexer switched only settles the sample and hold capacitor and is discarded,
+ * the second one is added to the running sum of the channel. Drivers take the sum
+ * and count (see AnalogInput) instead of calling the blocking analogRead().
+ * 
+ * A channel that is not taken for a while never drops new conversions: once WINDOW
+ * conversions are summed, the sum and count are halved, so older conversions lose
+ * weight and the average stays close to the newest ones.
+ * 
+ * In free-running mode the next conversion starts as soon as one completes, so the
+ * multiplexer written in the interrupt applies to the conversion after next.
+ * 
+ * On the native build the interrupt is simulated by NativeHAL at the conversion rate
+ * of the AVR.
+ */
+class AdcCapture
+{
+public:
+    static const uint8_t MAX_CHANNELS = 4;
+    static const uint8_t WINDOW = 32;     // about 27 ms of conversions with four channels
+
+    // prescaler 128 at 16 MHz, 13 ADC clocks per conversion
+    static const uint16_t CONVERSION_MICROS = 104;
+
+    static_assert(!BOARD_HAS_ADC_CAPTURE || static_cast<uint32_t>(WINDOW) * Board::maxCounts() <= 0xFFFF,
+                  "the running sum must fit 16 bits");
+
+    /**
+     * @brief starts free-running capture. analogRead() must not be used afterwards
+     * 
+     * @param pins analog pins to capture, at most MAX_CHANNELS
+     * @param count number of pins
+     */
+    static void begin(const uint8_t *pins, uint8_t count);
+
+    static void end();
+
+    static bool running();
+
+    /**
+     * @brief checks if a pin is in the channel list
+     */
+    static bool captures(uint8_t pin);
+
+    /**
+     * @brief number of conversions summed for a pin since the last take()
+     */
+    static uint8_t available(uint8_t pin);
+
+    /**
+     * @brief takes the running sum of a pin and starts a new one
+     * 
+     * @param pin captured pin
+     * @param sum receives the sum of the conversions
+     * @param count receives the number of conversions in the sum
+     * @return false if the pin is not captured or nothing was converted
+     */
+    static bool take(uint8_t pin, uint16_t &sum, uint8_t &count);
+
+    /**
+     * @brief interrupt body, called with the result of every completed conversion
+     */
+    static void onConversion(uint16_t value);
+};
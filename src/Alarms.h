@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Low/high threshold alarms with hysteresis, one per sample channel
+ *
+ * A channel goes into BELOW when a sample falls under its low limit and into ABOVE
+ * when a sample rises over its high limit. It only returns to NORMAL once a sample is
+ * back inside the limits by the hysteresis, so a value hovering at a limit does not
+ * toggle the alarm. A NaN limit never triggers.
+ *
+ * Every state change is kept as the pending event of its channel until it is taken
+ * with take(). A channel holds one event, the caller has to take it before the next
+ * change or it is replaced.
+ *
+ * @tparam CHANNELS number of sample channels
+ */
+template<uint8_t CHANNELS>
+class Alarms
+{
+public:
+    enum State : uint8_t {
+        NORMAL,
+        BELOW,
+        ABOVE
+    };
+
+private:
+    struct Channel
+    {
+        bool enabled = false;
+        float low = 0.0f;
+        float high = 0.0f;
+        float hysteresis = 0.0f;
+
+        State state = NORMAL;
+        bool pending = false;
+        float value;                // sample that changed the state
+    };
+
+    Channel channels[CHANNELS];
+
+public:
+    /**
+     * @brief enables the alarm of a channel, it starts in NORMAL
+     *
+     * @param id channel id
+     * @param low lower limit
+     * @param high upper limit
+     * @param hysteresis distance from a limit a sample needs to clear the alarm, at most
+     *          high - low so a cleared sample is always inside both limits
+     * @return false if the id or the limits are invalid
+     */
+    bool set(uint8_t id, float low, float high, float hysteresis)
+    {
+        if (id >= CHANNELS || low > high || hysteresis < 0.0f || hysteresis > high - low) return false;
+
+        Channel &channel = channels[id];
+        channel.enabled = true;
+        channel.low = low;
+        channel.high = high;
+        channel.hysteresis = hysteresis;
+        channel.state = NORMAL;
+        channel.pending = false;
+        return true;
+    }
+
+    /**
+     * @brief disables the alarm of a channel and drops its pending event
+     */
+    void disable(uint8_t id)
+    {
+        if (id >= CHANNELS) return;
+
+        channels[id].enabled = false;
+        channels[id].pending = false;
+    }
+
+    bool enabled(uint8_t id) const
+    {
+        return id < CHANNELS && channels[id].enabled;
+    }
+
+    void get(uint8_t id, float &low, float &high, float &hysteresis) const
+    {
+        low = channels[id].low;
+        high = channels[id].high;
+        hysteresis = channels[id].hysteresis;
+    }
+
+    State state(uint8_t id) const
+    {
+        return channels[id].state;
+    }
+
+    /**
+     * @brief evaluates a sample against the limits of its channel
+     *
+     * @param id channel id
+     * @param value sample
+     * @return true if the state changed, the change is pending then
+     */
+    bool update(uint8_t id, float value)
+    {
+        if (id >= CHANNELS || !channels[id].enabled) return false;
+
+        Channel &channel = channels[id];
+        State state = channel.state;
+
+        if (value < channel.low)                                        state = BELOW;
+        else if (value > channel.high)                                  state = ABOVE;
+        else if (state == BELOW && value >= channel.low + channel.hysteresis)  state = NORMAL;
+        else if (state == ABOVE && value <= channel.high - channel.hysteresis) state = NORMAL;
+
+        if (state == channel.state) return false;
+
+        channel.state = state;
+        channel.value = value;
+        channel.pending = true;
+        return true;
+    }
+
+    /**
+     * @brief checks if the channel has an event that was not taken yet
+     */
+    bool pending(uint8_t id) const
+    {
+        return id < CHANNELS && channels[id].pending;
+    }
+
+    /**
+     * @brief takes the pending event of a channel
+     *
+     * @param id channel id
+     * @param state receives the state the channel changed to
+     * @param value receives the sample that changed it
+     * @return false if there is no pending event
+     */
+    bool take(uint8_t id, State &state, float &value)
+    {
+        if (!pending(id)) return false;
+
+        channels[id].pending = false;
+        state = channels[id].state;
+        value = channels[id].value;
+        return true;
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+#include "AdcCapture.h"
+#include "Board.h"
+#include "utils.h"
+
+/**
+ * @brief Analog input driver with oversampling, the Driver policy of Sensor
+ *
+ * Every acquire() takes one settling conversion after the multiplexer switched to the
+ * pin, then 4^OVERSAMPLE_BITS conversions that are summed and decimated into a value
+ * with OVERSAMPLE_BITS extra bits of resolution.
+ *
+ * With USE_ADC_CAPTURE the conversions come from the running sum of the pin in
+ * AdcCapture instead: acquire() averages the conversions captured since the last call,
+ * weighted towards the newest, and never waits for the ADC. If nothing was captured,
+ * there is no new value.
+ *
+ * @tparam OVERSAMPLE_BITS extra bits of resolution, at most 3
+ * @tparam BoardTraits board profile that sets the ADC resolution and reference, see Board.h
+ */
+template<uint8_t OVERSAMPLE_BITS, class BoardTraits = Board::Current>
+class AnalogInput
+{
+    static_assert(OVERSAMPLE_BITS <= 3, "oversampling is limited to 64 conversions per sample");
+
+public:
+    static const uint8_t EXTRA_BITS = OVERSAMPLE_BITS;
+    static const uint8_t BITS = BoardTraits::ADC_BITS + OVERSAMPLE_BITS;
+    static const uint16_t MAX_COUNTS = Board::maxCounts<BoardTraits>() << OVERSAMPLE_BITS;
+
+private:
+    uint8_t pin;
+
+public:
+    AnalogInput(uint8_t pin)
+        : pin(pin)
+    { }
+
+    /**
+     * @brief takes one oversampled conversion
+     *
+     * @param counts receives the counts, at most MAX_COUNTS
+     * @return false if there is no new conversion, counts is left unchanged
+     */
+    bool acquire(uint16_t &counts)
+    {
+#ifdef USE_ADC_CAPTURE
+        uint16_t sum;
+        uint8_t count;
+        if (!AdcCapture::take(pin, sum, count)) return false;
+
+        counts = static_cast<uint16_t>((static_cast<uint32_t>(sum) << OVERSAMPLE_BITS) / count);
+#else
+        analogRead(pin);    // settle the sample and hold capacitor after the channel switch
+
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < (1 << (2 * OVERSAMPLE_BITS)); ++i) sum += analogRead(pin);
+
+        counts = static_cast<uint16_t>(sum >> OVERSAMPLE_BITS);
+#endif
+        return true;
+    }
+
+    /**
+     * @brief drops the conversions captured so far, the next acquire() only sees
+     *          conversions started afterwards
+     */
+    void discard()
+    {
+#ifdef USE_ADC_CAPTURE
+        uint16_t sum;
+        uint8_t count;
+        AdcCapture::take(pin, sum, count);
+#endif
+    }
+
+    /**
+     * @brief waits until acquire() has a new conversion. Polling always has one
+     *
+     * @param timeoutMicros longest wait
+     * @return false on timeout
+     */
+    bool wait(unsigned long timeoutMicros)
+    {
+#ifdef USE_ADC_CAPTURE
+        if (!AdcCapture::captures(pin)) return false;
+
+        unsigned long start = micros();
+        while (!AdcCapture::available(pin)) {
+            if (micros() - start >= timeoutMicros) return false;
+        }
+#endif
+        return true;
+    }
+
+    /**
+     * @brief millivolts per count of the oversampled value
+     */
+    static constexpr float millivoltsPerCount()
+    {
+        return Board::millivoltsPerCount<BoardTraits>(OVERSAMPLE_BITS);
+    }
+};
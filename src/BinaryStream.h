@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+#include "utils.h"
+#include "FixedPoint.h"
+
+/**
+ * @brief Compact binary sample stream
+ * 
+ * While active, every sample taken by the sample scheduler is sent as a fixed 8 byte
+ * packet, at most once per interval and channel:
+ * 
+ *      byte 0      sync 0xA5
+ *      byte 1      sensor id (sample channel)
+ *      byte 2      sequence number, incremented for every packet
+ *      byte 3..6   value, signed Q16.16 fixed-point, little endian
+ *      byte 7      CRC-8 (polynomial 0x07) of bytes 0..6
+ * 
+ * A packet that does not fit into the UART transmit buffer is dropped instead of
+ * stalling loop(). Its sequence number is still consumed so the host sees the gap.
+ * 
+ * @tparam CHANNELS number of sample channels
+ */
+template<uint8_t CHANNELS>
+class BinaryStream
+{
+public:
+    static const uint8_t SYNC = 0xA5;
+    static const uint8_t PACKET_SIZE = 8;
+
+private:
+    HardwareSerial &out;
+    bool enabled = false;
+    unsigned long interval = 0;
+    unsigned long last[CHANNELS];
+    uint8_t sequence = 0;
+
+public:
+    BinaryStream(HardwareSerial &out)
+        : out(out)
+    { }
+
+    /**
+     * @brief starts streaming
+     * 
+     * @param interval minimum time between two packets of the same channel in milliseconds
+     */
+    void start(unsigned long interval)
+    {
+        this->interval = interval;
+        for (uint8_t i = 0; i < CHANNELS; ++i) last[i] = millis() - interval;
+        enabled = true;
+    }
+
+    void stop()
+    {
+        enabled = false;
+    }
+
+    bool active() const
+    {
+        return enabled;
+    }
+
+    unsigned long getInterval() const
+    {
+        return interval;
+    }
+
+    /**
+     * @brief Sends the sample if streaming is active and the channel interval elapsed
+     * 
+     * @param id sample channel
+     * @param value sample
+     * @param now current millis()
+     */
+    void publish(uint8_t id, float value, unsigned long now)
+    {
+        if (!enabled || id >= CHANNELS || now - last[id] < interval) return;
+        last[id] = now;
+
+        Fixed::q16_t fixed = Fixed::fromFloat(value);
+
+        uint8_t packet[PACKET_SIZE];
+        packet[0] = SYNC;
+        packet[1] = id;
+        packet[2] = sequence++;
+        packet[3] = fixed;
+        packet[4] = fixed >> 8;
+        packet[5] = fixed >> 16;
+        packet[6] = fixed >> 24;
+        packet[7] = Utils::crc8(packet, PACKET_SIZE - 1);
+
+        if (out.availableForWrite() < PACKET_SIZE) return;
+        out.write(packet, PACKET_SIZE);
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Compile-time board profiles
+ *
+ * Every supported board is described by a traits struct: ADC resolution, reference
+ * voltage, buffer sizes and the optional peripherals that are present. Board::Current
+ * is the profile of the board being built, drivers take it as a default template
+ * argument so scale factors fold into constants.
+ *
+ * Optional peripherals are also exposed as BOARD_HAS_* macros because they decide
+ * which headers and translation units are compiled at all, see the USE_* switches in
+ * utils.h.
+ */
+#if defined(DUE) || defined(ARDUINO_SAM_DUE)
+    #define BOARD_DUE
+    #define BOARD_HAS_EEPROM        0
+    #define BOARD_HAS_ONE_WIRE      1
+    #define BOARD_HAS_ADC_CAPTURE   0
+#elif defined(NATIVE)
+    #define BOARD_NATIVE
+    #define BOARD_HAS_EEPROM        1
+    #define BOARD_HAS_ONE_WIRE      1
+    #define BOARD_HAS_ADC_CAPTURE   1
+#else
+    #define BOARD_UNO
+    #define BOARD_HAS_EEPROM        1
+    #define BOARD_HAS_ONE_WIRE      1
+    #define BOARD_HAS_ADC_CAPTURE   1
+#endif
+
+namespace Board {
+
+    /**
+     * @brief Arduino Uno, ATmega328P with 2 KB SRAM and 1 KB EEPROM
+     */
+    struct Uno
+    {
+        static constexpr uint8_t ADC_BITS = 10;
+        static constexpr float VREF_MILLIVOLTS = 5000.0f;
+
+        static constexpr bool HAS_EEPROM = true;
+        static constexpr bool HAS_ONE_WIRE = true;
+        static constexpr bool HAS_ADC_CAPTURE = true;       // free-running ADC interrupt, see AdcCapture.h
+        static constexpr uint16_t EEPROM_SIZE = 1024;       // bytes
+
+        static constexpr uint8_t LINE_SIZE = 64;            // longest command line
+        static constexpr uint8_t SAMPLE_DEPTH = 8;          // samples buffered per channel
+        static constexpr uint16_t LOG_SIZE = 256;           // bytes of the sample log
+        static constexpr uint8_t TEMPERATURE_PROBES = 3;    // DS18B20 on the 1-Wire bus
+        static constexpr uint8_t CALIBRATION_POINTS = 5;    // per sensor, see PiecewiseLinear.h
+    };
+
+    /**
+     * @brief Arduino Due, SAM3X8E with 96 KB SRAM and no EEPROM
+     */
+    struct Due
+    {
+        static constexpr uint8_t ADC_BITS = 12;
+        static constexpr float VREF_MILLIVOLTS = 3300.0f;
+
+        static constexpr bool HAS_EEPROM = false;
+        static constexpr bool HAS_ONE_WIRE = true;
+        static constexpr bool HAS_ADC_CAPTURE = false;
+        static constexpr uint16_t EEPROM_SIZE = 0;
+
+        static constexpr uint8_t LINE_SIZE = 128;
+        static constexpr uint8_t SAMPLE_DEPTH = 16;
+        static constexpr uint16_t LOG_SIZE = 4096;
+        static constexpr uint8_t TEMPERATURE_PROBES = 8;
+        static constexpr uint8_t CALIBRATION_POINTS = 8;
+    };
+
+    /**
+     * @brief Host build on the simulated HAL, behaves like an Uno
+     */
+    struct Native : Uno
+    { };
+
+#if defined(BOARD_DUE)
+    typedef Due Current;
+#elif defined(BOARD_NATIVE)
+    typedef Native Current;
+#else
+    typedef Uno Current;
+#endif
+
+    static_assert(Current::HAS_EEPROM == BOARD_HAS_EEPROM, "BOARD_HAS_EEPROM does not match the board profile");
+    static_assert(Current::HAS_ONE_WIRE == BOARD_HAS_ONE_WIRE, "BOARD_HAS_ONE_WIRE does not match the board profile");
+    static_assert(Current::HAS_ADC_CAPTURE == BOARD_HAS_ADC_CAPTURE, "BOARD_HAS_ADC_CAPTURE does not match the board profile");
+
+    /**
+     * @brief largest ADC reading
+     */
+    template<class Traits = Current>
+    constexpr uint16_t maxCounts()
+    {
+        return (1U << Traits::ADC_BITS) - 1;
+    }
+
+    /**
+     * @brief millivolts per count of an ADC reading with extraBits of oversampling
+     */
+    template<class Traits = Current>
+    constexpr float millivoltsPerCount(uint8_t extraBits = 0)
+    {
+        return Traits::VREF_MILLIVOLTS / maxCounts<Traits>() / (1 << extraBits);
+    }
+}
@@ -0,0 +1,83 @@
+#include "CalibrationStore.h"
+#include "utils.h"
+
+#ifdef USE_CALIBRATION_STORE
+
+#include <string.h>
+#include <EEPROM.h>
+
+static_assert(CalibrationStore::SLOTS >= 2, "the EEPROM must hold at least two calibration records");
+
+CalibrationStore::CalibrationStore(uint16_t baseAddress)
+    : baseAddress(baseAddress)
+{ }
+
+bool CalibrationStore::load(CalibrationData &data)
+{
+    current = -1;
+
+    Record record;
+    for (uint8_t slot = 0; slot < SLOTS; ++slot) {
+
+        EEPROM.get(address(slot), record);
+        if (record.version != VERSION || record.crc != checksum(record)) continue;
+
+        // serial number arithmetic keeps working after the sequence wraps around
+        if (current < 0 || static_cast<int16_t>(record.sequence - sequence) > 0) {
+            current = slot;
+            sequence = record.sequence;
+            data = record.data;
+        }
+    }
+
+    return current >= 0;
+}
+
+bool CalibrationStore::save(const CalibrationData &data)
+{
+    // compared in place, a second record would not fit on the stack of the Uno
+    if (current >= 0 && matches(address(current) + offsetof(Record, data), &data, sizeof(data))) {
+        return true;
+    }
+
+    uint8_t slot = current < 0 ? 0 : (current + 1) % SLOTS;
+
+    Record record;
+    record.version = VERSION;
+    record.sequence = sequence + 1;
+    record.data = data;
+    record.crc = checksum(record);
+    EEPROM.put(address(slot), record);
+
+    if (!matches(address(slot), &record, sizeof(record))) return false;
+
+    current = slot;
+    sequence = record.sequence;
+    return true;
+}
+
+size_t CalibrationStore::size()
+{
+    return SLOTS * sizeof(Record);
+}
+
+uint16_t CalibrationStore::address(uint8_t slot) const
+{
+    return baseAddress + slot * sizeof(Record);
+}
+
+bool CalibrationStore::matches(uint16_t address, const void *data, size_t size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        if (EEPROM.read(address + i) != bytes[i]) return false;
+    }
+    return true;
+}
+
+uint8_t CalibrationStore::checksum(const Record &record)
+{
+    return Utils::crc8(reinterpret_cast<const uint8_t *>(&record), offsetof(Record, crc));
+}
+
+#endif
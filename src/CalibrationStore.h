@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Board.h"
+#include "PiecewiseLinear.h"
+
+/**
+ * @brief Calibration values of every sensor and the alarm limits, persisted as one
+ *          record
+ */
+struct CalibrationData
+{
+    typedef CalibrationTable<Board::Current::CALIBRATION_POINTS> Table;
+
+    static const uint8_t ALARM_CHANNELS = 4;    // SampleChannel in main.cpp
+
+    // limits of a threshold alarm, see Alarms.h
+    struct Alarm
+    {
+        uint8_t enabled;
+        float low;
+        float high;
+        float hysteresis;
+    };
+
+    float phNeutral;
+    float phAcid;
+    float ecLow;
+    float ecHigh;
+    float turbM;
+    float turbB;
+    float tdsK;
+    float tdsFactor;
+    uint8_t tdsMode;        // TDS::Mode
+
+    // N-point calibrations, used instead of the values above when they have 2+ points
+    Table phTable;
+    Table ecTable;
+    Table turbTable;
+
+    Alarm alarms[ALARM_CHANNELS];
+};
+
+/**
+ * @brief Versioned, CRC protected calibration record in EEPROM with wear leveling
+ * 
+ * The record is written to SLOTS slots in turn, each write goes to the slot after the
+ * newest one with an incremented sequence number. load() picks the valid slot with
+ * the newest sequence number, so an interrupted write falls back to the previous
+ * record. Bytes that did not change are not rewritten.
+ */
+class CalibrationStore
+{
+private:
+    struct Record
+    {
+        uint8_t version;
+        uint16_t sequence;
+        CalibrationData data;
+        uint8_t crc;            // CRC-8 of all bytes before it
+    };
+
+public:
+    static const uint8_t VERSION = 4;
+    static const uint8_t MAX_SLOTS = 8;
+
+    // as many slots as fit into the EEPROM, at most MAX_SLOTS
+    static const uint8_t SLOTS = Board::Current::EEPROM_SIZE / sizeof(Record) < MAX_SLOTS
+                                     ? Board::Current::EEPROM_SIZE / sizeof(Record) : MAX_SLOTS;
+
+private:
+    uint16_t baseAddress;
+    int8_t current = -1;        // slot of the newest valid record, -1 if none
+    uint16_t sequence = 0;
+
+public:
+    /**
+     * @param baseAddress first EEPROM byte used by the store
+     */
+    CalibrationStore(uint16_t baseAddress = 0);
+
+    /**
+     * @brief reads the newest valid record
+     * 
+     * @param data receives the calibration, untouched if there is no valid record
+     * @return true if a valid record was found
+     */
+    bool load(CalibrationData &data);
+
+    /**
+     * @brief writes the calibration into the next slot. Nothing is written if it equals
+     *          the newest record
+     * 
+     * @return true if the record was written and verified
+     */
+    bool save(const CalibrationData &data);
+
+    /**
+     * @brief EEPROM bytes used by the store
+     */
+    static size_t size();
+
+private:
+    uint16_t address(uint8_t slot) const;
+
+    /**
+     * @brief checks if the EEPROM at address holds the given bytes
+     */
+    static bool matches(uint16_t address, const void *data, size_t size);
+
+    static uint8_t checksum(const Record &record);
+};
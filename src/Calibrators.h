@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include "Board.h"
+#include "FixedPoint.h"
+#include "PiecewiseLinear.h"
+#include "utils.h"
+
+/**
+ * @brief Calibration models shared by the sensors, the Calibrator policy of Sensor
+ *
+ * A model converts filtered ADC counts of its Input into the reading:
+ *
+ *      typedef ... Input                                   driver the counts come from
+ *      template<class Source>
+ *      float apply(Source &sensor, uint16_t counts)        may resample through sensor
+ *      float pointScale()                                  output scale of Points
+ *
+ * Sensor specific models live next to their sensor, e.g. PHCalibration in PH.h.
+ */
+namespace Calibrators {
+
+    /**
+     * @brief Adds an N-point calibration (PiecewiseLinear.h) in front of the model Base.
+     *          With two or more points they replace Base, which is kept for when the
+     *          points are cleared
+     *
+     * Points are stored unscaled, readings are multiplied by Base::pointScale(), e.g.
+     * the temperature compensation of EC.
+     *
+     * @tparam Base calibration model used without points
+     * @tparam N maximum number of points
+     */
+    template<class Base, uint8_t N = Board::Current::CALIBRATION_POINTS>
+    class Points : public Base
+    {
+    public:
+        typedef PiecewiseLinear<N> PointCalibration;
+
+    private:
+        PointCalibration points;
+
+    public:
+        Points()
+            : points(Base::Input::MAX_COUNTS)
+        { }
+
+        template<class Source>
+        float apply(Source &sensor, uint16_t counts)
+        {
+            if (!points.active()) return Base::apply(sensor, counts);
+
+            points.setScale(Base::pointScale());
+#ifdef USE_FIXED_POINT
+            return Fixed::toFloat(points.applyFixed(counts));
+#else
+            return points.apply(counts);
+#endif
+        }
+
+        /**
+         * @brief adds a point, or replaces the value of the point with the same counts
+         *
+         * @param value reading of the point, scaled like the readings
+         * @return false if the table is full
+         */
+        bool addPoint(uint16_t counts, float value)
+        {
+            return points.add(counts, value / Base::pointScale());
+        }
+
+        void clearCalibrationPoints()
+        {
+            points.clear();
+        }
+
+        const PointCalibration &getCalibrationPoints() const
+        {
+            return points;
+        }
+
+        /**
+         * @return false if the table is invalid, the sensor then has no N-point calibration
+         */
+        bool setCalibrationPoints(const typename PointCalibration::Table &table)
+        {
+            return points.load(table);
+        }
+    };
+}
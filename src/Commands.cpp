@@ -0,0 +1,129 @@
+#include "Commands.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+    bool isDelimiter(char c)
+    {
+        return c == ' ' || c == '\r' || c == '\n';
+    }
+
+    /**
+     * @brief splits line into words in place. Once max words are found, the last word
+     *          keeps the rest of the line
+     */
+    uint8_t tokenize(char *line, char **tokens, uint8_t max)
+    {
+        uint8_t count = 0;
+
+        while (*line) {
+
+            while (isDelimiter(*line)) ++line;
+            if (!*line) break;
+
+            tokens[count++] = line;
+            if (count == max) break;
+
+            while (*line && !isDelimiter(*line)) ++line;
+            if (*line) *line++ = '\0';
+        }
+
+        return count;
+    }
+
+    /**
+     * @brief checks that the first words tokens spell the PROGMEM path exactly
+     */
+    bool matches(const char *path, char **tokens, uint8_t words)
+    {
+        for (uint8_t i = 0; i < words; ++i) {
+
+            for (const char *c = tokens[i]; *c; ++c, ++path) {
+                if (pgm_read_byte(path) != *c) return false;
+            }
+
+            char end = pgm_read_byte(path++);
+            if (end != (i + 1 == words ? '\0' : ' ')) return false;
+        }
+
+        return true;
+    }
+
+    bool isNumber(const char *str)
+    {
+        char *end;
+        strtod(str, &end);
+        return end != str && *end == '\0';
+    }
+
+    /**
+     * @brief validates the arguments against the PROGMEM schema. A rest of line
+     *          argument is joined back into a single argument
+     */
+    bool validate(const char *schema, char **args, uint8_t &argc)
+    {
+        bool optional = false;
+        uint8_t i = 0;
+
+        for (char type = pgm_read_byte(schema); type; type = pgm_read_byte(++schema)) {
+
+            if (type == '?') {
+                optional = true;
+                continue;
+            }
+
+            if (type == '*') {
+                if (i < argc) {
+                    for (uint8_t j = i; j + 1 < argc; ++j) args[j][strlen(args[j])] = ' ';
+                    argc = i + 1;
+                }
+                return true;
+            }
+
+            if (i == argc) return optional;
+            if (type == 'n' && !isNumber(args[i])) return false;
+            ++i;
+        }
+
+        return i == argc;
+    }
+}
+
+Commands::Result Commands::dispatch(const Table &table, char *line)
+{
+    char *tokens[MAX_TOKENS];
+    uint8_t count = tokenize(line, tokens, MAX_TOKENS);
+
+    if (!count) return EMPTY;
+
+    // longest verb path wins, so "ph calibrate get" is preferred over "ph"
+    int8_t match = -1;
+    uint8_t words = 0;
+    uint16_t h = HASH_OFFSET;
+
+    for (uint8_t i = 0; i < count && i < MAX_PATH_WORDS; ++i) {
+
+        if (i) h = hashStep(h, ' ');
+        for (const char *c = tokens[i]; *c; ++c) h = hashStep(h, *c);
+
+        int8_t idx = table.find(h);
+        if (idx >= 0 && matches(reinterpret_cast<const char *>(pgm_read_ptr(&table.commands[idx].path)), tokens, i + 1)) {
+            match = idx;
+            words = i + 1;
+        }
+    }
+
+    if (match < 0) return UNKNOWN;
+
+    Command command;
+    memcpy_P(&command, &table.commands[match], sizeof(command));
+
+    char **args = tokens + words;
+    uint8_t argc = count - words;
+    if (!validate(command.schema, args, argc)) return BAD_ARGUMENTS;
+
+    command.handler(args, argc);
+    return OK;
+}
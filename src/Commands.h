@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+
+/**
+ * @brief Table driven command dispatcher
+ * 
+ * A command table is declared once as an X-macro listing every command with its id,
+ * its verb path, its argument schema and its handler:
+ * 
+ *      #define MY_COMMANDS(X)                                      \
+ *          X(PH,         "ph",               "",   phRead)        \
+ *          X(PH_CAL_SET, "ph calibrate set", "nn", phCalibrateSet)
+ * 
+ *      DEFINE_COMMAND_TABLE(commands, MY_COMMANDS)
+ * 
+ * Paths, schemas and the table itself are stored in PROGMEM. Lookup hashes the words
+ * of the command line once and switches on the hash of every path, which is computed
+ * at compile time. Two paths with the same hash fail to compile with a duplicate case
+ * value, so the hash is guaranteed to be perfect for the table and dispatch costs
+ * O(length of the command) regardless of how many commands exist.
+ * 
+ * Argument schema, one character per argument:
+ *      'n'     number
+ *      's'     single word
+ *      '*'     rest of the line, can be empty. Must be last
+ *      '?'     the arguments that follow are optional
+ */
+namespace Commands {
+
+    const uint8_t MAX_TOKENS     = 10;      // path words + arguments
+    const uint8_t MAX_PATH_WORDS = 3;
+
+    const uint16_t HASH_OFFSET = 0x811C;
+    const uint16_t HASH_PRIME  = 0x0193;
+
+    /**
+     * @brief Command handler
+     * 
+     * @param args arguments following the verb path, validated against the schema
+     * @param argc number of arguments
+     */
+    typedef void (*Handler)(char **args, uint8_t argc);
+
+    struct Command
+    {
+        const char *path;       // PROGMEM
+        const char *schema;     // PROGMEM
+        Handler handler;
+    };
+
+    struct Table
+    {
+        const Command *commands;        // PROGMEM
+        uint8_t size;
+        int8_t (*find)(uint16_t hash);
+    };
+
+    enum Result : uint8_t
+    {
+        OK,
+        EMPTY,
+        UNKNOWN,
+        BAD_ARGUMENTS
+    };
+
+    inline uint16_t hashStep(uint16_t hash, char c)
+    {
+        return static_cast<uint16_t>((hash ^ static_cast<uint8_t>(c)) * HASH_PRIME);
+    }
+
+    /**
+     * @brief 16 bit FNV-1a hash, usable at compile time
+     */
+    constexpr uint16_t hash(const char *str, uint16_t h = HASH_OFFSET)
+    {
+        return *str ? hash(str + 1, static_cast<uint16_t>((h ^ static_cast<uint8_t>(*str)) * HASH_PRIME)) : h;
+    }
+
+    /**
+     * @brief Splits the line into words, finds the longest matching verb path, validates
+     *          the arguments and calls the handler
+     * 
+     * @param table command table
+     * @param line command line without the leading '/'. Modified in place
+     * @return Result OK if a handler was called
+     */
+    Result dispatch(const Table &table, char *line);
+}
+
+#define COMMAND_DECLARE_(id, path, schema, handler) \
+    static const char COMMAND_PATH_##id[] PROGMEM = path; \
+    static const char COMMAND_SCHEMA_##id[] PROGMEM = schema;
+
+#define COMMAND_INDEX_(id, path, schema, handler) COMMAND_INDEX_##id,
+
+#define COMMAND_ENTRY_(id, path, schema, handler) { COMMAND_PATH_##id, COMMAND_SCHEMA_##id, handler },
+
+#define COMMAND_CASE_(id, path, schema, handler) case Commands::hash(path): return COMMAND_INDEX_##id;
+
+#define DEFINE_COMMAND_TABLE(name, TABLE) \
+    TABLE(COMMAND_DECLARE_) \
+    enum : int8_t { TABLE(COMMAND_INDEX_) }; \
+    static const Commands::Command name##_COMMANDS[] PROGMEM = { TABLE(COMMAND_ENTRY_) }; \
+    static int8_t name##_find(uint16_t hash) \
+    { \
+        switch (hash) { \
+        TABLE(COMMAND_CASE_) \
+        default: return -1; \
+        } \
+    } \
+    const Commands::Table name = { name##_COMMANDS, sizeof(name##_COMMANDS) / sizeof(name##_COMMANDS[0]), name##_find };
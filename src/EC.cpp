@@ -3,51 +3,62 @@
 #include "utils.h"
 #include <Arduino.h>
 
-EC::EC(uint8_t pin, WaterTemperature *waterTemperature):
-    pin(pin),
-    waterTemperature(waterTemperature)
+ECCalibration::ECCalibration()
 {
-    
+    updateCoefficients(25.0f);
 }
 
-void EC::init()
+void ECCalibration::setWaterTemperatureSensor(WaterTemperature *sensor)
 {
-    // nothing to do
+    this->waterTemperature = sensor;
 }
 
-void EC::setWaterTemperatureSensor(WaterTemperature *sensor)
+bool ECCalibration::highRange() const
 {
-    this->waterTemperature = sensor;
+    return high;
 }
 
-float EC::read(uint8_t _)
+bool ECCalibration::selectRange(uint16_t counts, bool high) const
 {
-    // algorithm based on DFRobot EC library
-    static float kValue = 1.0f;
-    
-    for (int i = 0; i < 5; ++i) analogRead(pin);
-    float voltage = rawRead();
-    float temperature = waterTemperature ? waterTemperature->read() : 25.0f;
+    float valTmp = counts * ecPerCount() * (high ? kValueHigh : kValueLow);
 
-    float rawEC = 1000.0f * voltage / RES2 / ECREF;
-    float valTmp = rawEC * kValue;
+    if (valTmp > 2.5f)      return true;
+    else if (valTmp < 2.0f) return false;
+    return high;
+}
 
-    if (valTmp > 2.5f)      kValue = kValueHigh;
-    else if (valTmp < 2.0f) kValue = kValueLow;
+float ECCalibration::convert(uint16_t counts, bool high, float temperature) const
+{
+    float voltage = counts * Input::millivoltsPerCount();
+    float rawEC = 1000.0f * voltage / RES2 / ECREF;
+    float kValue = high ? kValueHigh : kValueLow;
 
     return (rawEC * kValue) / (1.0f + 0.0185f * (temperature - 25.0f));
 }
 
-size_t EC::write(char *buffer, uint8_t idx)
+void ECCalibration::updateCoefficients(float temperature)
 {
+    float kValues[2] = { kValueLow, kValueHigh };
+
+    compensation = 1.0f / (1.0f + 0.0185f * (temperature - 25.0f));
+
+    for (uint8_t range = 0; range < 2; ++range) {
+
+        float gain = ecPerCount() * kValues[range];
+        fixed[range].set(gain * compensation, 0.0f, Input::MAX_COUNTS);
+
+        // rawEC * kValue > 2.5 <=> counts > 2.5 / gain, same for the 2.0 threshold
+        rangeUp[range]   = static_cast<uint16_t>(min(floor(2.5f / gain), 65535.0f));
+        rangeDown[range] = static_cast<uint16_t>(min(ceil(2.0f / gain), 65535.0f));
+    }
 
+    coefficientTemperature = temperature;
 }
 
-bool EC::calibrate()
+bool ECCalibration::calibrate(uint16_t counts)
 {
-    for (int i = 0; i < 5; ++i) analogRead(pin);
-    float voltage = rawRead();
-    float temperature = waterTemperature ? waterTemperature->read() : 25.0f;
+    float voltage = counts * Input::millivoltsPerCount();
+    float temperature = compensationTemperature();
     float rawEC = 1000.0f * voltage / RES2 / ECREF;
 
     float compECSolution;
@@ -71,17 +82,19 @@ bool EC::calibrate()
         return false;
     }
 
+    updateCoefficients(temperature);
     return true;
 }
 
-void EC::getCalibration(float &lowValue, float &highValue)
+void ECCalibration::getCalibration(float &lowValue, float &highValue)
 {
     lowValue  = kValueLow;
     highValue = kValueHigh;
 }
 
-void EC::setCalibration(float lowValue, float highValue)
+void ECCalibration::setCalibration(float lowValue, float highValue)
 {
     kValueLow  = lowValue;
     kValueHigh = highValue;
+    updateCoefficients(coefficientTemperature);
 }
@@ -1,41 +1,186 @@
 #pragma once
 
-#include "SensorInterface.h"
 #include "WaterTemperature.h"
 #include "utils.h"
+#include "FixedPoint.h"
+#include "AnalogInput.h"
+#include "Filters.h"
+#include "Calibrators.h"
+#include "Profiler.h"
+#include "Sensor.h"
 
 #define RES2  820.0f
 #define ECREF 200.0f
 
-class EC : public SensorInterface
+/**
+ * @brief Temperature compensated EC calibration with a k value for the low and the
+ *          high range, based on the DFRobot EC driver
+ */
+class ECCalibration
 {
+public:
+    // one extra bit by oversampling
+    typedef AnalogInput<1> Input;
+
+    // fresh samples taken after a range switch, fills the median window
+    static const uint8_t SETTLE_SAMPLES = 5;
+
+    static const uint8_t PROBE = Profiler::EC_READ;
+
 private:
-    uint8_t pin;
-    WaterTemperature *waterTemperature;
+    WaterTemperature *waterTemperature = nullptr;
+
+    // range of the last reading, switched with hysteresis between the 2.0 and 2.5
+    // raw EC thresholds
+    bool high = false;
     
     float kValueLow = 1.0f;
     float kValueHigh = 1.0f;
+
+    // fixed-point coefficients per range for the temperature they were computed for.
+    // Recomputed when the calibration or the water temperature changes
+    float coefficientTemperature;
+    float compensation;
+    Fixed::Linear fixed[2];
+    uint16_t rangeUp[2];        // switch to the high range above this many counts
+    uint16_t rangeDown[2];      // switch to the low range below this many counts
     
 public:
-    EC(uint8_t pin, WaterTemperature *WaterTemperature=nullptr);
+    ECCalibration();
 
-    void init();
+    static const char *field() { return "ec"; }
 
     void setWaterTemperatureSensor(WaterTemperature *sensor);
 
-    float read(uint8_t _=0);
+    /**
+     * @brief converts to the temperature compensated EC. If the sample crosses into
+     *          the other range, the filter of the sensor is restarted on fresh samples
+     *          and the range is decided again, so the returned value already belongs
+     *          to the settled range
+     */
+    template<class Source>
+    float apply(Source &sensor, uint16_t counts)
+    {
+        // algorithm based on DFRobot EC library
+        float temperature = compensationTemperature();
 
-    size_t write(char *buffer, uint8_t idx=0);
+        if (nextRange(counts) != high) {
+            // the median still holds samples of before the step, decide on fresh ones
+            counts = sensor.settle(SETTLE_SAMPLES);
+            high = nextRange(counts);
+        }
 
-    bool calibrate();
+#ifdef USE_FIXED_POINT
+        return Fixed::toFloat(convertFixed(counts, high, temperature));
+#else
+        return convert(counts, high, temperature);
+#endif
+    }
+
+    /**
+     * @brief temperature compensation factor, N-point calibrations hold the
+     *          uncompensated EC
+     */
+    float pointScale()
+    {
+        float temperature = compensationTemperature();
+        if (temperature != coefficientTemperature) updateCoefficients(temperature);
+        return compensation;
+    }
+
+    /**
+     * @brief checks if the last reading used the high range calibration
+     */
+    bool highRange() const;
+
+    /**
+     * @brief takes the sample as the 1.413 or 12.88 mS/cm reference solution,
+     *          whichever range it falls in
+     * 
+     * @return false if the sample is in neither range or the k value is implausible
+     */
+    bool calibrate(uint16_t counts);
 
     void getCalibration(float &lowValue, float &highValue);
 
     void setCalibration(float lowValue, float highValue);
 
+    /**
+     * @brief float reference of the range selection
+     * 
+     * @param counts ADC counts
+     * @param high range used for the previous sample
+     * @return true if the sample belongs to the high range
+     */
+    bool selectRange(uint16_t counts, bool high) const;
+
+    /**
+     * @brief range selection on precomputed ADC count thresholds
+     */
+    bool selectRangeFixed(uint16_t counts, bool high) const
+    {
+        if (counts > rangeUp[high])        return true;
+        else if (counts < rangeDown[high]) return false;
+        return high;
+    }
+
+    /**
+     * @brief float reference conversion from ADC counts to temperature compensated EC
+     * 
+     * @param counts ADC counts
+     * @param high use the high range calibration
+     * @param temperature water temperature in Celsius
+     */
+    float convert(uint16_t counts, bool high, float temperature) const;
+
+    /**
+     * @brief fixed-point conversion from ADC counts to temperature compensated EC
+     */
+    Fixed::q16_t convertFixed(uint16_t counts, bool high, float temperature)
+    {
+        // the temperature only changes once per conversion of the probe
+        if (temperature != coefficientTemperature) updateCoefficients(temperature);
+
+        return fixed[high].apply(counts);
+    }
+
 private:
-    inline float rawRead()
+    void updateCoefficients(float temperature);
+
+    /**
+     * @brief range of a sample given the current range, fixed-point or float reference
+     */
+    bool nextRange(uint16_t counts) const
     {
-        return analogRead(pin) / ANALOG_RESOLUTION * VREF * 1000.0f;
+#ifdef USE_FIXED_POINT
+        return selectRangeFixed(counts, high);
+#else
+        return selectRange(counts, high);
+#endif
+    }
+
+    /**
+     * @brief raw EC per ADC count before the k value is applied
+     */
+    static constexpr float ecPerCount()
+    {
+        return 1000.0f * Input::millivoltsPerCount() / RES2 / ECREF;
+    }
+
+    /**
+     * @brief cached water temperature in Celsius. Never waits on the 1-Wire bus.
+     *          Falls back to 25 C if there is no sensor or no valid reading yet
+     */
+    inline float compensationTemperature()
+    {
+#ifdef USE_WATER_TEMPERATURE
+        return waterTemperature && waterTemperature->valid() ? waterTemperature->readCelsius() : 25.0f;
+#else
+        return 25.0f;
+#endif
     }
 };
+
+// a running median rejects spikes, the N-point calibration replaces the k values and
+// the range switching once it has two points
+typedef Sensor<ECCalibration::Input, Filters::Median<5>, Calibrators::Points<ECCalibration> > EC;
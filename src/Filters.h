@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Composable sample filters working on integer ADC counts
+ * 
+ * Every stage keeps its own state and filters one sample per call, so no stage ever
+ * waits for the next sample:
+ * 
+ *      int32_t push(int32_t sample)    feeds a sample and returns the filtered value
+ *      void reset()                    forgets the history
+ * 
+ * Stages are combined with Chain, e.g. Chain<Median<5>, Ema<2> > removes spikes first
+ * and smooths the result afterwards. Chain<> passes samples through unchanged.
+ */
+namespace Filters {
+
+    /**
+     * @brief Running median of the last N samples, rejects single sample spikes
+     */
+    template<uint8_t N>
+    class Median
+    {
+    private:
+        int32_t window[N];
+        uint8_t head = 0;
+        uint8_t count = 0;
+
+    public:
+        int32_t push(int32_t sample)
+        {
+            window[head] = sample;
+            head = (head + 1) % N;
+            if (count < N) ++count;
+
+            // insertion sort of a copy, N is small
+            int32_t sorted[N];
+            for (uint8_t i = 0; i < count; ++i) {
+                int32_t value = window[i];
+                uint8_t j = i;
+                for (; j > 0 && sorted[j - 1] > value; --j) sorted[j] = sorted[j - 1];
+                sorted[j] = value;
+            }
+
+            return sorted[count / 2];
+        }
+
+        void reset()
+        {
+            head = 0;
+            count = 0;
+        }
+    };
+
+    /**
+     * @brief Moving average (boxcar) of the last N samples with a running sum
+     */
+    template<uint8_t N>
+    class Boxcar
+    {
+    private:
+        int32_t window[N];
+        int32_t sum = 0;
+        uint8_t head = 0;
+        uint8_t count = 0;
+
+    public:
+        int32_t push(int32_t sample)
+        {
+            if (count == N) sum -= window[head];
+            else ++count;
+
+            window[head] = sample;
+            sum += sample;
+            head = (head + 1) % N;
+
+            return sum / count;
+        }
+
+        void reset()
+        {
+            sum = 0;
+            head = 0;
+            count = 0;
+        }
+    };
+
+    /**
+     * @brief Exponential moving average with alpha = 1 / 2^SHIFT. The state keeps SHIFT
+     *          extra fraction bits so small steps are not lost to rounding
+     */
+    template<uint8_t SHIFT>
+    class Ema
+    {
+    private:
+        int32_t state = 0;
+        bool primed = false;
+
+    public:
+        int32_t push(int32_t sample)
+        {
+            if (!primed) {
+                state = sample << SHIFT;
+                primed = true;
+            }
+            else {
+                state += sample - (state >> SHIFT);
+            }
+
+            return state >> SHIFT;
+        }
+
+        void reset()
+        {
+            primed = false;
+        }
+    };
+
+    /**
+     * @brief Runs the stages in order, the output of one stage is the input of the next
+     */
+    template<class... Stages>
+    class Chain;
+
+    template<>
+    class Chain<>
+    {
+    public:
+        int32_t push(int32_t sample) { return sample; }
+        void reset() {}
+    };
+
+    template<class First, class... Rest>
+    class Chain<First, Rest...>
+    {
+    private:
+        First first;
+        Chain<Rest...> rest;
+
+    public:
+        int32_t push(int32_t sample)
+        {
+            return rest.push(first.push(sample));
+        }
+
+        void reset()
+        {
+            first.reset();
+            rest.reset();
+        }
+    };
+
+    typedef Chain<> None;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @brief Q16.16 fixed-point helpers for the conversion kernels. The ATmega328P has
+ *          no FPU, an integer multiply-add is several times cheaper than the emulated
+ *          float operations it replaces
+ */
+namespace Fixed {
+
+    typedef int32_t q16_t;
+
+    const uint8_t FRACTION_BITS = 16;
+    const q16_t ONE = 1L << FRACTION_BITS;
+
+    inline q16_t fromFloat(float value)
+    {
+        return static_cast<q16_t>(value * ONE + (value < 0.0f ? -0.5f : 0.5f));
+    }
+
+    inline float toFloat(q16_t value)
+    {
+        return value * (1.0f / ONE);
+    }
+
+    /**
+     * @brief y = gain * x + offset with y in Q16.16 and an integer input x
+     * 
+     * The gain is stored with as many fraction bits as the input range allows without
+     * overflowing the 32 bit product, so the quantization error stays far below the
+     * resolution of the ADC.
+     */
+    struct Linear
+    {
+        int32_t gain = 0;
+        q16_t offset = 0;
+        uint8_t shift = FRACTION_BITS;      // fraction bits of gain
+
+        /**
+         * @brief precomputes the coefficients, call whenever the calibration changes
+         * 
+         * @param gain slope of the conversion
+         * @param offset output for x = 0
+         * @param maxInput largest input value passed to apply()
+         * @return false if gain or offset are not finite or the offset does not fit
+         *          Q16.16, the coefficients are left unchanged then
+         */
+        bool set(float gain, float offset, int32_t maxInput)
+        {
+            if (!isfinite(gain) || !isfinite(offset) || fabs(offset) >= 32767.0f) return false;
+
+            shift = 30;
+            while (shift > 0 && fabs(gain) * maxInput * static_cast<float>(1UL << shift) >= 2147483647.0f) --shift;
+
+            this->gain = static_cast<int32_t>(gain * static_cast<float>(1UL << shift) + (gain < 0.0f ? -0.5f : 0.5f));
+            this->offset = fromFloat(offset);
+            return true;
+        }
+
+        q16_t apply(int32_t x) const
+        {
+            int32_t product = gain * x;
+            // the product may be negative, scale up by a multiply instead of a left shift
+            return (shift >= FRACTION_BITS ? product >> (shift - FRACTION_BITS)
+                                           : product * (1L << (FRACTION_BITS - shift))) + offset;
+        }
+    };
+}
@@ -0,0 +1,44 @@
+#include "Format.h"
+
+#include <math.h>
+#include <Arduino.h>
+
+size_t Format::unsignedInteger(Print &out, uint32_t value)
+{
+    uint32_t power = 1;
+    while (value / power >= 10) power *= 10;
+
+    size_t n = 0;
+    for (; power; power /= 10) n += out.write('0' + value / power % 10);
+    return n;
+}
+
+size_t Format::decimal(Print &out, float value, uint8_t decimals, uint32_t scale)
+{
+    if (isnan(value)) return out.print(F("nan"));
+    if (isinf(value)) return out.print(F("inf"));
+
+    bool negative = value < 0;
+    if (negative) value = -value;
+    if (value >= 4294967040.0f) return out.print(F("ovf"));
+
+    // the fraction is scaled on its own so large integer parts keep their decimals
+    uint32_t integer = static_cast<uint32_t>(value);
+    uint32_t fraction = static_cast<uint32_t>((value - integer) * scale + 0.5f);
+    if (fraction >= scale) {
+        ++integer;
+        fraction -= scale;
+    }
+
+    size_t n = 0;
+    if (negative && (integer || fraction)) n += out.write('-');
+    n += unsignedInteger(out, integer);
+
+    if (decimals) {
+        n += out.write('.');
+        for (uint32_t power = scale / 10; power; power /= 10) {
+            n += out.write('0' + fraction / power % 10);
+        }
+    }
+    return n;
+}
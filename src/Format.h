@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <Print.h>
+
+/**
+ * @brief Streaming number formatter
+ * 
+ * Floats are split into an integer part and a fraction rounded to DECIMALS decimal
+ * places. Both are written as integers, most significant digit first, straight to the
+ * Print, so nothing is staged in a string buffer and no float printf support is
+ * needed. Written to Serial, the characters go directly into the UART transmit buffer.
+ * 
+ * The "nan"/"inf"/"ovf" markers follow Print::print(float, digits). Unlike Print, the
+ * fraction is rounded half up and values that round to zero are printed without sign.
+ */
+namespace Format {
+
+    template<uint8_t DECIMALS>
+    struct Scale
+    {
+        static const uint32_t VALUE = 10 * Scale<DECIMALS - 1>::VALUE;
+    };
+
+    template<>
+    struct Scale<0>
+    {
+        static const uint32_t VALUE = 1;
+    };
+
+    /**
+     * @brief writes value with a fixed number of decimals
+     * 
+     * @param out destination
+     * @param value number to write
+     * @param decimals digits after the decimal point
+     * @param scale 10^decimals
+     * @return size_t characters written
+     */
+    size_t decimal(Print &out, float value, uint8_t decimals, uint32_t scale);
+
+    /**
+     * @brief writes an unsigned integer in base 10
+     * 
+     * @return size_t characters written
+     */
+    size_t unsignedInteger(Print &out, uint32_t value);
+
+    /**
+     * @brief writes value with DECIMALS digits after the decimal point
+     * 
+     * @tparam DECIMALS digits after the decimal point, at most 9
+     * @return size_t characters written
+     */
+    template<uint8_t DECIMALS>
+    size_t decimal(Print &out, float value)
+    {
+        static_assert(DECIMALS <= 9, "the scaled value must fit into 32 bits");
+        return decimal(out, value, DECIMALS, Scale<DECIMALS>::VALUE);
+    }
+
+    /**
+     * @brief Print into a caller provided char array, always null terminated. Output
+     *          that does not fit is dropped
+     */
+    class BufferPrint : public Print
+    {
+        char *buffer;
+        size_t size;
+        size_t length = 0;
+
+    public:
+        BufferPrint(char *buffer, size_t size)
+            : buffer(buffer), size(size)
+        {
+            if (size) buffer[0] = '\0';
+        }
+
+        size_t write(uint8_t c)
+        {
+            if (length + 1 >= size) return 0;
+            buffer[length++] = c;
+            buffer[length] = '\0';
+            return 1;
+        }
+
+        using Print::write;
+
+        size_t written() const { return length; }
+    };
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <Stream.h>
+
+/**
+ * @brief Incremental, non-blocking command line assembler
+ * 
+ * poll() consumes whatever bytes are available and keeps its state between calls,
+ * so loop() never waits for a command to arrive. A line starts with '/' and ends
+ * with '\r' or '\n', or after the line was idle for the timeout. Bytes outside of a
+ * line are ignored. Lines are double buffered: the next line is assembled while the
+ * previous one is handed out, and reading stops at the next terminator until the
+ * previous line is released.
+ * 
+ * @tparam SIZE size of one line buffer, including the NULL terminator
+ */
+template<uint8_t SIZE>
+class LineReader
+{
+private:
+    char lines[2][SIZE];
+    uint8_t active = 0;         // buffer being assembled
+    uint8_t length = 0;
+
+    bool started = false;       // '/' received, assembling a line
+    bool discarding = false;    // line is too long, dropping bytes until the terminator
+    bool ready = false;         // lines[active ^ 1] holds a complete line
+    bool overflow = false;
+
+    unsigned long timeout;
+    unsigned long lastByte = 0;
+
+public:
+    /**
+     * @param timeout idle time in milliseconds after which a partial line is complete
+     */
+    LineReader(unsigned long timeout = 1000)
+        : timeout(timeout)
+    { }
+
+    /**
+     * @brief Consumes the available bytes of the stream without waiting
+     * 
+     * @param stream input stream
+     * @param now current millis()
+     */
+    void poll(Stream &stream, unsigned long now)
+    {
+        while (stream.available() > 0) {
+
+            int c = stream.peek();
+            bool terminator = c == '\r' || c == '\n';
+
+            // the previous line is still in use, keep the terminator in the stream
+            if (started && terminator && ready) return;
+
+            stream.read();
+            lastByte = now;
+
+            if (!started) {
+                if (c == '/') {
+                    started = true;
+                    discarding = false;
+                    length = 0;
+                }
+            }
+            else if (terminator) {
+                finish();
+            }
+            else if (length == SIZE - 1) {
+                discarding = true;
+            }
+            else {
+                lines[active][length++] = c;
+            }
+        }
+
+        if (started && !ready && now - lastByte >= timeout) finish();
+    }
+
+    /**
+     * @brief returns the complete line without the leading '/', or nullptr if there is
+     *          none. The line stays valid until release()
+     */
+    char *line()
+    {
+        return ready ? lines[active ^ 1] : nullptr;
+    }
+
+    /**
+     * @brief hands the buffer of the current line back to the reader
+     */
+    void release()
+    {
+        ready = false;
+    }
+
+    /**
+     * @brief true once after a line longer than SIZE - 1 characters was dropped
+     */
+    bool overflowed()
+    {
+        bool result = overflow;
+        overflow = false;
+        return result;
+    }
+
+    static uint8_t capacity() { return SIZE - 1; }
+
+private:
+    void finish()
+    {
+        started = false;
+
+        if (discarding) {
+            overflow = true;
+            return;
+        }
+
+        lines[active][length] = '\0';
+        active ^= 1;
+        ready = true;
+    }
+};
@@ -3,32 +3,25 @@
 #include "Arduino.h"
 #include "utils.h"
 
-PH::PH(uint8_t pin)
-    : pin(pin)
-{ }
-
-void PH::init()
+PHCalibration::PHCalibration()
 {
-    // nothing to do
+    updateCoefficients();
 }
 
-float PH::read(uint8_t _)
+void PHCalibration::updateCoefficients()
 {
     // based on DFRobot PH Driver
-    float slope = (7.0f - 4.0f )/ ((this->neutralVoltage-1500.0f) / 3.0f - (this->acidVoltage-1500.0f) / 3.0f);  // two point: (_neutralVoltage,7.0),(_acidVoltage,4.0)
-    float intercept =  7.0f - slope * (this->neutralVoltage-1500.0f) / 3.0f;
+    slope = (7.0f - 4.0f )/ ((this->neutralVoltage-1500.0f) / 3.0f - (this->acidVoltage-1500.0f) / 3.0f);  // two point: (_neutralVoltage,7.0),(_acidVoltage,4.0)
+    intercept =  7.0f - slope * (this->neutralVoltage-1500.0f) / 3.0f;
 
-    for (int i = 0; i < 5; ++i) rawRead();  // get accurate reading
-    float voltage = rawRead();
-    return slope * (voltage - 1500.0f) / 3.0f + intercept;
+    // ph = slope * (counts * mV per count - 1500) / 3 + intercept, folded into gain * counts + offset
+    fixed.set(slope * Input::millivoltsPerCount() / 3.0f, intercept - slope * 500.0f, Input::MAX_COUNTS);
 }
 
-bool PH::calibrate()
+bool PHCalibration::calibrate(uint16_t counts)
 {
-    for (int i = 0; i < 5; ++i) rawRead();  // get accurate reading
-    
-    float voltage = rawRead();
-    
+    float voltage = counts * Input::millivoltsPerCount();
+
     if (voltage > 1322.0f && voltage < 1678.0f){        // buffer solution:7.0{
         neutralVoltage = voltage;
     }else if (voltage > 1854 && voltage<2210){  //buffer solution:4.0
@@ -38,28 +31,28 @@ bool PH::calibrate()
         return false;
     }
 
+    updateCoefficients();
     return true;
 }
 
-void PH::getCalibration(float &neutralVoltage, float &acidicVoltage)
+void PHCalibration::getCalibration(float &neutralVoltage, float &acidicVoltage)
 {
     neutralVoltage = this->neutralVoltage;
     acidicVoltage = this->acidVoltage;
 }
 
-void PH::setCalibration(float neutralVoltage, float acidVoltage)
+bool PHCalibration::setCalibration(float neutralVoltage, float acidVoltage)
 {
+    // equal voltages make the slope infinite
+    if (!isfinite(neutralVoltage) || !isfinite(acidVoltage) || neutralVoltage == acidVoltage) return false;
+
     this->neutralVoltage = neutralVoltage;
     this->acidVoltage    = acidVoltage;
+    updateCoefficients();
+    return true;
 }
 
-float PH::readTemp()
+float PHCalibration::readTemp()
 {
     return 25.0f;
 }
-
-size_t PH::write(char *buffer, uint8_t idx)
-{
-    sprintf(buffer, "\"ph\": %.6f,", read());
-    return strlen(buffer);
-}
@@ -1,47 +1,94 @@
 #pragma once
 
-#include "SensorInterface.h"
 #include <stdint.h>
 #include "utils.h"
+#include "FixedPoint.h"
+#include "AnalogInput.h"
+#include "Filters.h"
+#include "Calibrators.h"
+#include "Profiler.h"
+#include "Sensor.h"
 // #include "DFRobot_PH.h"
-#include "WaterTemperature.h"
 
-class PH : public SensorInterface
+/**
+ * @brief Two-point ph calibration on the voltages of the ph 7.0 and 4.0 buffer
+ *          solutions, based on the DFRobot ph driver
+ */
+class PHCalibration
 {
+public:
+    // one extra bit by oversampling
+    typedef AnalogInput<1> Input;
+
+    static const uint8_t PROBE = Profiler::PH_READ;
+
 private:
-    uint8_t pin;
     float neutralVoltage = 1500.0f;
     float acidVoltage = 2032.44f;
-    
+
+    // conversion coefficients, recomputed when the calibration changes
+    float slope;
+    float intercept;
+    Fixed::Linear fixed;
+
 public:
-    PH(uint8_t pin);
+    PHCalibration();
+
+    static const char *field() { return "ph"; }
+
+    template<class Source>
+    float apply(Source &sensor, uint16_t counts)
+    {
+#ifdef USE_FIXED_POINT
+        return Fixed::toFloat(convertFixed(counts));
+#else
+        return convert(counts);
+#endif
+    }
+
+    float pointScale() const { return 1.0f; }
 
-    void init();
-    
     /**
-     * @brief returns ph reading
-     * 
-     * @param _ unused
-     * @return float ph reading
+     * @brief takes the sample as the voltage of the buffer solution it falls in
+     *
+     * @return false if the sample is in neither buffer range
      */
-    float read(uint8_t _=0);
+    bool calibrate(uint16_t counts);
 
-    size_t write(char *buffer, uint8_t idx=0);
+    void getCalibration(float &neutralVoltage, float &acidicVoltage);
 
-    bool calibrate();
+    /**
+     * @return false if the voltages are not finite or equal, the calibration is left
+     *          unchanged then
+     */
+    bool setCalibration(float neutralVoltage, float acidicVoltage);
 
-    void getCalibration(float &neutralVoltage, float &acidicVoltage);
+    /**
+     * @brief float reference conversion from ADC counts to ph
+     */
+    float convert(uint16_t counts) const
+    {
+        float voltage = counts * Input::millivoltsPerCount();
+        return slope * (voltage - 1500.0f) / 3.0f + intercept;
+    }
 
-    void setCalibration(float neutralVoltage, float acidicVoltage);
+    /**
+     * @brief fixed-point conversion from ADC counts to ph
+     */
+    Fixed::q16_t convertFixed(uint16_t counts) const
+    {
+        return fixed.apply(counts);
+    }
 
     /**
      * @brief Deprecated - non functioning
      */
-    virtual float readTemp();
+    float readTemp();
 
 private:
-    inline float rawRead()
-    {
-        return analogRead(pin) / ANALOG_RESOLUTION * VREF * 1000.0f;
-    }
+    void updateCoefficients();
 };
+
+// a running median rejects spikes, the N-point calibration replaces the two-point
+// calibration once it has two points
+typedef Sensor<PHCalibration::Input, Filters::Median<5>, Calibrators::Points<PHCalibration> > PH;
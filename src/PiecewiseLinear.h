@@ -0,0 +1,182 @@
+#pragma once
+
+#include <stdint.h>
+#include "FixedPoint.h"
+
+/**
+ * @brief Calibration point, a sensor reading in ADC counts and the value it stands for
+ */
+struct CalibrationPoint
+{
+    uint16_t counts;
+    float value;
+};
+
+/**
+ * @brief Points of an N-point calibration as they are persisted, sorted by counts
+ */
+template<uint8_t N>
+struct CalibrationTable
+{
+    uint8_t count;
+    CalibrationPoint points[N];
+};
+
+/**
+ * @brief N-point calibration by piecewise-linear interpolation
+ *
+ * Every segment between two neighbouring points is precomputed into a Q16.16
+ * multiply-add (Fixed::Linear) whenever the points or the output scale change, so a
+ * conversion is one binary search over the breakpoints and one multiply-add. Inputs
+ * outside the points are extrapolated along the first or last segment. At least two
+ * points are needed, see active().
+ *
+ * @tparam N maximum number of points
+ */
+template<uint8_t N>
+class PiecewiseLinear
+{
+    static_assert(N >= 2, "a piecewise-linear calibration needs at least two points");
+
+public:
+    typedef CalibrationTable<N> Table;
+
+private:
+    Table table;
+    Fixed::Linear segments[N - 1];
+    int32_t maxInput;
+    float scale = 1.0f;
+
+public:
+    /**
+     * @param maxInput largest input passed to apply()
+     */
+    PiecewiseLinear(int32_t maxInput)
+        : maxInput(maxInput)
+    {
+        table.count = 0;
+    }
+
+    /**
+     * @brief checks if there are enough points to convert
+     */
+    bool active() const { return table.count >= 2; }
+
+    uint8_t size() const { return table.count; }
+
+    static uint8_t capacity() { return N; }
+
+    const CalibrationPoint &operator[](uint8_t i) const { return table.points[i]; }
+
+    const Table &points() const { return table; }
+
+    void clear()
+    {
+        table.count = 0;
+    }
+
+    /**
+     * @brief adds a point, or replaces the value of the point with the same counts
+     *
+     * @return false if the table is full
+     */
+    bool add(uint16_t counts, float value)
+    {
+        uint8_t i = 0;
+        while (i < table.count && table.points[i].counts < counts) ++i;
+
+        if (i == table.count || table.points[i].counts != counts) {
+            if (table.count == N) return false;
+            for (uint8_t j = table.count; j > i; --j) table.points[j] = table.points[j - 1];
+            ++table.count;
+        }
+
+        table.points[i].counts = counts;
+        table.points[i].value = value;
+        build();
+        return true;
+    }
+
+    /**
+     * @brief replaces all points, e.g. with a table loaded from EEPROM
+     *
+     * @return false and no points if the table is not strictly sorted by counts
+     */
+    bool load(const Table &table)
+    {
+        clear();
+        if (table.count > N) return false;
+
+        for (uint8_t i = 1; i < table.count; ++i) {
+            if (table.points[i].counts <= table.points[i - 1].counts) return false;
+        }
+
+        this->table = table;
+        build();
+        return true;
+    }
+
+    /**
+     * @brief multiplies every output by scale, e.g. a temperature compensation factor
+     */
+    void setScale(float scale)
+    {
+        if (scale == this->scale) return;
+        this->scale = scale;
+        build();
+    }
+
+    /**
+     * @brief fixed-point conversion, one binary search and one multiply-add. Requires
+     *          active()
+     *
+     * @param counts ADC counts, at most maxInput
+     * @return Fixed::q16_t scaled value
+     */
+    Fixed::q16_t applyFixed(uint16_t counts) const
+    {
+        return segments[segment(counts)].apply(counts);
+    }
+
+    /**
+     * @brief float reference of applyFixed()
+     */
+    float apply(uint16_t counts) const
+    {
+        uint8_t i = segment(counts);
+        const CalibrationPoint &a = table.points[i];
+        const CalibrationPoint &b = table.points[i + 1];
+
+        float slope = (b.value - a.value) / (static_cast<float>(b.counts) - a.counts);
+        return (a.value + slope * (static_cast<float>(counts) - a.counts)) * scale;
+    }
+
+private:
+    /**
+     * @brief index of the segment that converts counts, the last point at or below
+     *          counts clamped to the first and last segment
+     */
+    uint8_t segment(uint16_t counts) const
+    {
+        uint8_t low = 0;
+        uint8_t high = table.count - 2;
+
+        while (low < high) {
+            uint8_t mid = (low + high + 1) / 2;
+            if (table.points[mid].counts <= counts) low = mid;
+            else high = mid - 1;
+        }
+        return low;
+    }
+
+    void build()
+    {
+        for (uint8_t i = 0; i + 1 < table.count; ++i) {
+            const CalibrationPoint &a = table.points[i];
+            const CalibrationPoint &b = table.points[i + 1];
+
+            float gain = (b.value - a.value) / (static_cast<float>(b.counts) - a.counts) * scale;
+            segments[i].set(gain, a.value * scale - gain * a.counts, maxInput);
+        }
+    }
+};
@@ -0,0 +1,57 @@
+#include "Profiler.h"
+
+#ifdef PROFILE
+
+#include <string.h>
+
+namespace {
+
+#define PROFILER_NAME_(id, name) static const char PROBE_NAME_##id[] PROGMEM = name;
+    PROFILER_PROBES(PROFILER_NAME_)
+#undef PROFILER_NAME_
+
+#define PROFILER_NAME_ENTRY_(id, name) PROBE_NAME_##id,
+    const char *const names[Profiler::PROBE_COUNT] PROGMEM = {
+        PROFILER_PROBES(PROFILER_NAME_ENTRY_)
+    };
+#undef PROFILER_NAME_ENTRY_
+
+    Profiler::Stats probes[Profiler::PROBE_COUNT];
+
+    uint8_t bucket(uint32_t micros)
+    {
+        uint8_t i = 0;
+        while (micros >>= 1) {
+            if (++i == Profiler::BUCKETS - 1) break;
+        }
+        return i;
+    }
+}
+
+void Profiler::record(uint8_t probe, uint32_t micros)
+{
+    Stats &stats = probes[probe];
+    ++stats.count;
+    stats.total += micros;
+    if (micros > stats.max) stats.max = micros;
+
+    uint16_t &count = stats.buckets[bucket(micros)];
+    if (count != UINT16_MAX) ++count;
+}
+
+const Profiler::Stats &Profiler::stats(uint8_t probe)
+{
+    return probes[probe];
+}
+
+const char *Profiler::name(uint8_t probe)
+{
+    return (const char *) pgm_read_ptr(&names[probe]);
+}
+
+void Profiler::reset()
+{
+    memset(probes, 0, sizeof(probes));
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+
+/**
+ * @brief Scoped timing probes for the hot paths, built only with -D PROFILE
+ * 
+ * A probe measures the time from PROFILE_SCOPE(id) to the end of the enclosing scope
+ * with micros() and adds it to the fixed histogram of the probe. Bucket i counts
+ * durations in [2^i, 2^(i+1)) microseconds, the last bucket also holds everything
+ * longer. Without PROFILE the macro expands to nothing and none of this is compiled.
+ * 
+ * Probes are listed once in PROFILER_PROBES, each entry is X(ID, "name").
+ * PROFILE_SCOPE_PROBE(probe) takes the Probe as a value instead, for templates that
+ * get it from a policy.
+ */
+#define PROFILER_PROBES(X) \
+    X(LOOP,             "loop")             \
+    X(LINE_POLL,        "line.poll")        \
+    X(CMD_DISPATCH,     "cmd.dispatch")     \
+    X(PH_READ,          "ph.read")          \
+    X(EC_READ,          "ec.read")          \
+    X(TURB_READ,        "turb.read")        \
+    X(TDS_READ,         "tds.read")         \
+    X(TEMP_UPDATE,      "temp.update")
+
+namespace Profiler {
+
+#define PROFILER_ENUM_(id, name) id,
+    enum Probe : uint8_t {
+        PROFILER_PROBES(PROFILER_ENUM_)
+        PROBE_COUNT
+    };
+#undef PROFILER_ENUM_
+
+    static const uint8_t BUCKETS = 14;
+
+    struct Stats
+    {
+        uint32_t count;
+        uint32_t total;         // microseconds
+        uint32_t max;           // microseconds
+        uint16_t buckets[BUCKETS];
+    };
+
+#ifdef PROFILE
+    void record(uint8_t probe, uint32_t micros);
+
+    const Stats &stats(uint8_t probe);
+
+    /**
+     * @brief name of a probe, in PROGMEM
+     */
+    const char *name(uint8_t probe);
+
+    void reset();
+
+    class Scope
+    {
+        uint8_t probe;
+        unsigned long start;
+
+    public:
+        Scope(uint8_t probe)
+            : probe(probe), start(micros())
+        { }
+
+        ~Scope()
+        {
+            record(probe, micros() - start);
+        }
+    };
+#endif
+}
+
+#ifdef PROFILE
+    #define PROFILE_CONCAT_(a, b) a##b
+    #define PROFILE_SCOPE_(id, line) Profiler::Scope PROFILE_CONCAT_(profileScope, line)(Profiler::id)
+    #define PROFILE_SCOPE(id) PROFILE_SCOPE_(id, __LINE__)
+    #define PROFILE_SCOPE_PROBE_(probe, line) Profiler::Scope PROFILE_CONCAT_(profileScope, line)(probe)
+    #define PROFILE_SCOPE_PROBE(probe) PROFILE_SCOPE_PROBE_(probe, __LINE__)
+#else
+    #define PROFILE_SCOPE(id)
+    #define PROFILE_SCOPE_PROBE(probe)
+#endif
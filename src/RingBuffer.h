@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include "utils.h"
+
+/**
+ * @brief Fixed-size ring buffer. Once full, pushing overwrites the oldest element
+ * 
+ * @tparam T element type
+ * @tparam N capacity
+ */
+template<class T, uint8_t N>
+class RingBuffer
+{
+private:
+    T data[N];
+    uint8_t head = 0;       // index of the next write
+    uint8_t count = 0;
+
+public:
+    void push(const T &value)
+    {
+        data[head] = value;
+        head = (head + 1) % N;
+        if (count < N) ++count;
+    }
+
+    void clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+    uint8_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    bool full() const { return count == N; }
+
+    static uint8_t capacity() { return N; }
+
+    /**
+     * @brief returns the i-th element, 0 being the oldest. i must be less than size()
+     */
+    const T &operator[](uint8_t i) const
+    {
+        return data[(head + N - count + i) % N];
+    }
+
+    /**
+     * @brief returns the newest element. The buffer must not be empty
+     */
+    const T &latest() const
+    {
+        return data[(head + N - 1) % N];
+    }
+
+    /**
+     * @brief median of the buffered elements. The buffer must not be empty
+     */
+    T median() const
+    {
+        T sorted[N];
+        for (uint8_t i = 0; i < count; ++i) sorted[i] = (*this)[i];
+
+        Utils::quickSort(sorted, 0, count - 1);
+        return sorted[count / 2];
+    }
+
+    /**
+     * @brief arithmetic mean of the buffered elements. The buffer must not be empty
+     */
+    T average() const
+    {
+        T sum = 0;
+        for (uint8_t i = 0; i < count; ++i) sum += (*this)[i];
+
+        return sum / count;
+    }
+};
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @brief Circular on-device log of timestamped snapshots of all channels
+ *
+ * Values are quantized to 1/SCALE and every record only stores the difference to
+ * the record before it:
+ *
+ *      varint      milliseconds since the previous record
+ *      varint      zigzag encoded value difference, once per channel
+ *
+ * Varints are little endian base 128, so slowly changing readings take one or two
+ * bytes per channel. Once the buffer is full the oldest records are dropped. The
+ * values of a dropped record are folded into the base state, so the oldest record
+ * left is still decoded relative to the right values.
+ *
+ * A dump walks the log one record per next() call, so it can be sent while loop()
+ * keeps running. Records appended during a dump are included.
+ *
+ * @tparam SIZE bytes of record storage
+ * @tparam CHANNELS values per record
+ */
+template<uint16_t SIZE, uint8_t CHANNELS>
+class SampleLog
+{
+public:
+    static const int32_t SCALE = 100;
+    static const int32_t LIMIT = (int32_t(1) << 30) - 1;     // keeps differences in int32
+    static const uint8_t MAX_RECORD_SIZE = 5 * (CHANNELS + 1);
+
+    static_assert(SIZE >= MAX_RECORD_SIZE, "SampleLog must hold at least one record");
+
+private:
+    struct State
+    {
+        unsigned long time;
+        int32_t values[CHANNELS];
+    };
+
+    uint8_t data[SIZE];
+    uint16_t tail = 0;          // offset of the oldest record
+    uint16_t used = 0;
+    uint16_t count = 0;
+
+    State base;                 // state before the oldest record
+    State last;                 // state after the newest record
+
+    bool dumpActive = false;
+    uint16_t cursor = 0;        // offset of the next record to dump
+    uint16_t remaining = 0;     // records left to dump
+    State cursorState;
+
+public:
+    SampleLog()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        tail = 0;
+        used = 0;
+        count = 0;
+        dumpActive = false;
+        base.time = 0;
+        for (uint8_t i = 0; i < CHANNELS; ++i) base.values[i] = 0;
+        last = base;
+    }
+
+    /**
+     * @brief appends a record, dropping the oldest records if there is no room
+     *
+     * @param time millis() of the snapshot
+     * @param values one value per channel
+     */
+    void append(unsigned long time, const float *values)
+    {
+        uint8_t record[MAX_RECORD_SIZE];
+        uint8_t size = putVarint(record, time - last.time);
+
+        State next;
+        next.time = time;
+        for (uint8_t i = 0; i < CHANNELS; ++i) {
+            next.values[i] = quantize(values[i]);
+            size += putVarint(record + size, zigzag(next.values[i] - last.values[i]));
+        }
+
+        while (SIZE - used < size) drop();
+
+        uint16_t head = (tail + used) % SIZE;
+        for (uint8_t i = 0; i < size; ++i) data[(head + i) % SIZE] = record[i];
+        used += size;
+        ++count;
+        last = next;
+
+        if (dumpActive) ++remaining;
+    }
+
+    uint16_t records() const { return count; }
+
+    uint16_t bytes() const { return used; }
+
+    static uint16_t capacity() { return SIZE; }
+
+    /**
+     * @brief starts a dump from the oldest record
+     *
+     * @return uint16_t records in the log
+     */
+    uint16_t startDump()
+    {
+        dumpActive = count > 0;
+        cursor = tail;
+        remaining = count;
+        cursorState = base;
+        return count;
+    }
+
+    bool dumping() const { return dumpActive; }
+
+    /**
+     * @brief decodes the next record of the dump
+     *
+     * @param time receives the millis() of the record
+     * @param values receives one value per channel
+     * @return true if a record was decoded, false once the dump is complete
+     */
+    bool next(unsigned long &time, float *values)
+    {
+        if (!dumpActive || !remaining) {
+            dumpActive = false;
+            return false;
+        }
+
+        cursor = decode(cursor, cursorState);
+        --remaining;
+
+        time = cursorState.time;
+        for (uint8_t i = 0; i < CHANNELS; ++i) values[i] = cursorState.values[i] / float(SCALE);
+        return true;
+    }
+
+private:
+    /**
+     * @brief drops the oldest record and folds it into the base state
+     */
+    void drop()
+    {
+        uint16_t next = decode(tail, base);
+
+        if (dumpActive && remaining && cursor == tail) {
+            // the record was not sent yet, the dump continues after it
+            cursor = next;
+            cursorState = base;
+            --remaining;
+        }
+
+        used -= (next + SIZE - tail) % SIZE;
+        tail = next;
+        --count;
+    }
+
+    /**
+     * @brief applies the record at offset to state
+     *
+     * @return uint16_t offset of the following record
+     */
+    uint16_t decode(uint16_t offset, State &state) const
+    {
+        state.time += getVarint(offset);
+        for (uint8_t i = 0; i < CHANNELS; ++i) state.values[i] += unzigzag(getVarint(offset));
+        return offset;
+    }
+
+    uint32_t getVarint(uint16_t &offset) const
+    {
+        uint32_t value = 0;
+        uint8_t shift = 0;
+        uint8_t byte;
+        do {
+            byte = data[offset];
+            offset = (offset + 1) % SIZE;
+            value |= uint32_t(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        return value;
+    }
+
+    static uint8_t putVarint(uint8_t *out, uint32_t value)
+    {
+        uint8_t size = 0;
+        while (value >= 0x80) {
+            out[size++] = value | 0x80;
+            value >>= 7;
+        }
+        out[size++] = value;
+        return size;
+    }
+
+    static uint32_t zigzag(int32_t value)
+    {
+        return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+    }
+
+    static int32_t unzigzag(uint32_t value)
+    {
+        return int32_t(value >> 1) ^ -int32_t(value & 1);
+    }
+
+    static int32_t quantize(float value)
+    {
+        if (value != value) return 0;       // NaN
+        value *= SCALE;
+        if (value > LIMIT) return LIMIT;
+        if (value < -LIMIT) return -LIMIT;
+        return lround(value);
+    }
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+#include "RingBuffer.h"
+
+/**
+ * @brief Cooperative sampler driven from loop(). Every channel wraps a sensor and is
+ *          sampled at its own period into its own ring buffer. update() takes at most one
+ *          sample per call so a single pass of loop() stays short.
+ * 
+ * attach() is a template on the concrete sensor type and stores a thunk that calls
+ * read() on that type. For a final sensor like Sensor<> the virtual read() is
+ * devirtualized and the whole sample path is inlined into the thunk. The thunk itself
+ * is still an indirect call through a function pointer, one per sample.
+ * 
+ * @tparam CHANNELS maximum number of channels
+ * @tparam DEPTH number of samples kept per channel
+ */
+template<uint8_t CHANNELS, uint8_t DEPTH>
+class SampleScheduler
+{
+public:
+    typedef RingBuffer<float, DEPTH> Buffer;
+
+    /**
+     * @brief called for every sample taken
+     * 
+     * @param id channel id
+     * @param value sample
+     * @param now millis() of the sample
+     */
+    typedef void (*Listener)(uint8_t id, float value, unsigned long now);
+
+private:
+    typedef float (*Reader)(void *sensor);
+
+    struct Channel
+    {
+        Reader read = nullptr;
+        void *sensor = nullptr;
+        unsigned long period = 0;
+        unsigned long last = 0;
+        Buffer samples;
+    };
+
+    Channel channels[CHANNELS];
+    uint8_t next = 0;       // round robin starting point of the next update
+    Listener listener = nullptr;
+
+    template<class SensorType>
+    static float readSensor(void *sensor)
+    {
+        return static_cast<SensorType *>(sensor)->read();
+    }
+
+public:
+    /**
+     * @brief Registers a sensor
+     * 
+     * @param id channel id, must be less than CHANNELS
+     * @tparam SensorType concrete type of the sensor, read() is called on it
+     * @param sensor initialized sensor to sample
+     * @param period time between two samples in milliseconds
+     * @return true if registered
+     */
+    template<class SensorType>
+    bool attach(uint8_t id, SensorType *sensor, unsigned long period)
+    {
+        if (id >= CHANNELS) return false;
+
+        channels[id].read = &readSensor<SensorType>;
+        channels[id].sensor = sensor;
+        channels[id].period = period;
+        channels[id].last = millis() - period;  // first sample is due immediately
+        channels[id].samples.clear();
+        return true;
+    }
+
+    /**
+     * @brief Stops sampling a channel, its buffer can still be filled by record()
+     */
+    void detach(uint8_t id)
+    {
+        if (id >= CHANNELS) return;
+
+        channels[id].read = nullptr;
+        channels[id].sensor = nullptr;
+        channels[id].samples.clear();
+    }
+
+    void setListener(Listener listener)
+    {
+        this->listener = listener;
+    }
+
+    void setPeriod(uint8_t id, unsigned long period)
+    {
+        if (id < CHANNELS) channels[id].period = period;
+    }
+
+    /**
+     * @brief Samples the first channel that is due, starting after the channel sampled last
+     * 
+     * @param now current millis()
+     * @return true if a sample was taken
+     */
+    bool update(unsigned long now)
+    {
+        for (uint8_t n = 0; n < CHANNELS; ++n) {
+
+            uint8_t id = (next + n) % CHANNELS;
+            Channel &channel = channels[id];
+
+            if (!channel.read || now - channel.last < channel.period) continue;
+
+            channel.last = now;
+            channel.samples.push(channel.read(channel.sensor));
+            if (listener) listener(id, channel.samples.latest(), now);
+            next = (id + 1) % CHANNELS;
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Buffers a sample produced outside of update(), e.g. a channel derived from
+     *          another one, and passes it to the listener like a sampled one
+     * 
+     * @param id channel id
+     * @param value sample
+     * @param now millis() of the sample
+     */
+    void record(uint8_t id, float value, unsigned long now)
+    {
+        if (id >= CHANNELS) return;
+
+        channels[id].samples.push(value);
+        if (listener) listener(id, value, now);
+    }
+
+    const Buffer &samples(uint8_t id) const
+    {
+        return channels[id].samples;
+    }
+
+    /**
+     * @brief Drops the buffered samples, e.g. after the calibration of the sensor changed
+     */
+    void clear(uint8_t id)
+    {
+        if (id < CHANNELS) channels[id].samples.clear();
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stdint.h>
+#include "SensorInterface.h"
+#include "Profiler.h"
+#include "utils.h"
+
+/**
+ * @brief Analog sensor composed from a driver, a filter chain and a calibration model
+ *
+ * Every policy is a template argument:
+ *
+ *      Driver      acquires oversampled ADC counts, see AnalogInput.h
+ *                      bool acquire(uint16_t &counts)      false if there is no new value
+ *                      void discard()                      drops pending conversions
+ *                      bool wait(unsigned long micros)     waits for the next conversion
+ *      Filter      filters the counts, see Filters.h
+ *      Calibrator  converts the filtered counts into the reading, e.g. PHCalibration
+ *                      float apply(Sensor &sensor, uint16_t counts)
+ *                      static const char *field()          name of the record field
+ *                      static const uint8_t PROBE          profiler probe of read()
+ *
+ * The sensor inherits the calibrator, so the calibration methods of the model are
+ * methods of the sensor. The class is final, a read() through the concrete type is a
+ * single inlined path from the ADC to the reading. The sample scheduler calls it
+ * through a thunk on the concrete type (see SampleScheduler::attach), only the
+ * command handlers that read a sensor without a buffered sample go through
+ * SensorInterface.
+ *
+ * A channel is declared as a typedef next to its calibration model, e.g.
+ *
+ *      typedef Sensor<PHCalibration::Input, Filters::Median<5>, Calibrators::Points<PHCalibration> > PH;
+ */
+template<class Driver, class Filter, class Calibrator>
+class Sensor final : public SensorInterface, public Calibrator
+{
+public:
+    typedef Driver Input;
+
+    // a full round of the capture channels takes about 1 ms on the Uno
+    static const unsigned long SETTLE_TIMEOUT_MICROS = 5000;
+
+private:
+    Driver driver;
+    Filter filter;
+    uint16_t last = 0;
+    bool primed = false;        // a conversion went through the filter
+
+public:
+    Sensor(uint8_t pin)
+        : driver(pin)
+    { }
+
+    void init() override
+    {
+        // nothing to do
+    }
+
+    /**
+     * @brief returns one filtered, calibrated sample
+     *
+     * @param _ unused
+     * @return float reading
+     */
+    float read(uint8_t _=0) override
+    {
+        PROFILE_SCOPE_PROBE(Calibrator::PROBE);
+        return Calibrator::apply(*this, sample());
+    }
+
+    size_t write(char *buffer, uint8_t idx=0) override
+    {
+        return Utils::writeField(buffer, FIELD_SIZE, Calibrator::field(), read());
+    }
+
+    /**
+     * @brief takes one conversion and feeds it through the filter
+     *
+     * @return uint16_t filtered counts, the previous ones if there was no new conversion
+     */
+    uint16_t sample()
+    {
+        // the first sample after boot waits for a conversion instead of reporting 0 counts
+        if (!primed) driver.wait(SETTLE_TIMEOUT_MICROS);
+
+        uint16_t counts;
+        if (driver.acquire(counts)) {
+            last = static_cast<uint16_t>(filter.push(static_cast<int32_t>(counts)));
+            primed = true;
+        }
+        return last;
+    }
+
+    /**
+     * @brief restarts the filter on fresh samples, for when the signal stepped and the
+     *          filter history no longer applies. Blocks until the samples are taken,
+     *          waits at most SETTLE_TIMEOUT_MICROS for each conversion
+     *
+     * @param samples number of fresh samples fed into the filter
+     * @return uint16_t filtered counts after the last sample
+     */
+    uint16_t settle(uint8_t samples)
+    {
+        filter.reset();
+        driver.discard();
+
+        for (uint8_t i = 0; i < samples; ++i) {
+            driver.wait(SETTLE_TIMEOUT_MICROS);
+            sample();
+        }
+        return last;
+    }
+
+    /**
+     * @brief calibrates the model on a fresh sample of a reference solution, for
+     *          models with bool calibrate(uint16_t counts)
+     */
+    bool calibrate()
+    {
+        return Calibrator::calibrate(sample());
+    }
+
+    /**
+     * @brief adds an N-point calibration point from a fresh sample, for models wrapped
+     *          in Calibrators::Points
+     *
+     * @param value reading the sample stands for
+     * @return false if the calibration table is full
+     */
+    bool addCalibrationPoint(float value)
+    {
+        return Calibrator::addPoint(sample(), value);
+    }
+};
@@ -3,11 +3,32 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+/**
+ * @brief Common interface of every sensor driver, so new sensors plug into the
+ *          command handlers by implementing it. Analog channels implement it with
+ *          Sensor (Sensor.h), whose per-sample path does not go through this interface
+ */
 class SensorInterface
 {
-    virtual void init();
+public:
+    virtual void init() = 0;
     
-    virtual float read(uint8_t idx=0);
+    /**
+     * @brief takes one sample and returns the converted reading
+     * 
+     * @param idx sensor specific channel index
+     * @return float reading
+     */
+    virtual float read(uint8_t idx=0) = 0;
 
-    virtual size_t write(char *buffer, uint8_t idx);
+    /**
+     * @brief takes one sample and writes it as a record field `"name": value,`
+     * 
+     * @param buffer receives the null terminated field, at least FIELD_SIZE bytes
+     * @param idx sensor specific channel index
+     * @return size_t length of the field
+     */
+    virtual size_t write(char *buffer, uint8_t idx) = 0;
+
+    static const size_t FIELD_SIZE = 24;
 };
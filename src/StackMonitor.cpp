@@ -0,0 +1,85 @@
+#include "StackMonitor.h"
+
+#include <Arduino.h>
+
+#ifdef __AVR__
+
+// symbols of the avr-libc linker script and malloc()
+extern uint8_t __data_start;
+extern uint8_t __heap_start;
+extern uint8_t *__brkval;
+
+/**
+ * @brief paints the unused SRAM. Runs from .init3, after the C runtime set up the stack
+ *          pointer and before it calls main(), so nothing is on the stack yet
+ */
+static void paintStack() __attribute__((naked, used, section(".init3")));
+
+static void paintStack()
+{
+    for (uint8_t *p = &__heap_start; p <= (uint8_t *) RAMEND; ++p) *p = StackMonitor::PAINT;
+}
+
+namespace {
+
+    uint8_t *heapEnd()
+    {
+        return __brkval ? __brkval : &__heap_start;
+    }
+
+    /**
+     * @brief lowest address the stack has reached
+     */
+    uint8_t *stackLow()
+    {
+        uint8_t *p = heapEnd();
+        while (p <= (uint8_t *) RAMEND && *p == StackMonitor::PAINT) ++p;
+        return p;
+    }
+}
+
+bool StackMonitor::supported()
+{
+    return true;
+}
+
+uint16_t StackMonitor::staticSize()
+{
+    return &__heap_start - &__data_start;
+}
+
+uint16_t StackMonitor::heapSize()
+{
+    return heapEnd() - &__heap_start;
+}
+
+uint16_t StackMonitor::stackPeak()
+{
+    return (uint8_t *) RAMEND + 1 - stackLow();
+}
+
+uint16_t StackMonitor::freeNow()
+{
+    return (uint8_t *) SP - heapEnd();
+}
+
+uint16_t StackMonitor::freeMin()
+{
+    return stackLow() - heapEnd();
+}
+
+#else
+
+bool StackMonitor::supported() { return false; }
+
+uint16_t StackMonitor::staticSize() { return 0; }
+
+uint16_t StackMonitor::heapSize() { return 0; }
+
+uint16_t StackMonitor::stackPeak() { return 0; }
+
+uint16_t StackMonitor::freeNow() { return 0; }
+
+uint16_t StackMonitor::freeMin() { return 0; }
+
+#endif
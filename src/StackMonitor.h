@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Stack high-water mark by stack painting
+ * 
+ * Before main() runs, all SRAM between the end of the static data and the top of the
+ * stack is filled with PAINT. The stack grows down into the painted area and the heap
+ * grows up into it, the bytes still painted were never touched by either. The deepest
+ * stack use since reset is the distance from the top of SRAM down to the highest
+ * painted byte that is left.
+ * 
+ * Only implemented on AVR, supported() is false elsewhere and every size reads 0.
+ */
+class StackMonitor
+{
+public:
+    static const uint8_t PAINT = 0xC5;
+
+    static bool supported();
+
+    /**
+     * @brief bytes of SRAM used by .data and .bss
+     */
+    static uint16_t staticSize();
+
+    /**
+     * @brief bytes currently allocated to the heap
+     */
+    static uint16_t heapSize();
+
+    /**
+     * @brief deepest stack use since reset in bytes
+     */
+    static uint16_t stackPeak();
+
+    /**
+     * @brief bytes currently free between the heap and the stack
+     */
+    static uint16_t freeNow();
+
+    /**
+     * @brief fewest bytes that were ever free between the heap and the stack
+     */
+    static uint16_t freeMin();
+};
@@ -0,0 +1,89 @@
+#include "TDS.h"
+#include "utils.h"
+#include <Arduino.h>
+
+void TDSCalibration::setWaterTemperatureSensor(WaterTemperature *sensor)
+{
+    this->waterTemperature = sensor;
+}
+
+void TDSCalibration::getCalibration(float &kValue, float &factor)
+{
+    kValue = this->kValue;
+    factor = this->factor;
+}
+
+void TDSCalibration::setCalibration(float kValue, float factor)
+{
+    this->kValue = kValue;
+    this->factor = factor;
+}
+
+float TDSCalibration::convert(uint16_t counts, float temperature) const
+{
+    // algorithm based on the DFRobot Gravity TDS sample code: the voltage is compensated
+    // to 25 C before the cubic of the probe, not the EC after it
+    float voltage = counts * Input::millivoltsPerCount() / 1000.0f / (1.0f + 0.02f * (temperature - 25.0f));
+    float ec25 = (133.42f * voltage * voltage * voltage - 255.86f * voltage * voltage + 857.39f * voltage) * kValue;
+
+    return ec25 * factor;
+}
+
+TDS::TDS(uint8_t pin)
+    : probe(pin)
+{ }
+
+void TDS::init()
+{
+    probe.init();
+}
+
+float TDS::read(uint8_t _)
+{
+    if (mode == DIRECT) return probe.read();
+
+    PROFILE_SCOPE(TDS_READ);
+    if (!hasEC && ecSensor) updateEC(ecSensor->read());
+    return probe.fromEC(ec);
+}
+
+size_t TDS::write(char *buffer, uint8_t idx)
+{
+    return Utils::writeField(buffer, FIELD_SIZE, TDSCalibration::field(), read());
+}
+
+void TDS::setWaterTemperatureSensor(WaterTemperature *sensor)
+{
+    probe.setWaterTemperatureSensor(sensor);
+}
+
+void TDS::setECSensor(SensorInterface *sensor)
+{
+    ecSensor = sensor;
+}
+
+void TDS::updateEC(float ec)
+{
+    this->ec = ec;
+    hasEC = true;
+}
+
+TDS::Mode TDS::getMode() const
+{
+    return mode;
+}
+
+void TDS::setMode(Mode mode)
+{
+    this->mode = mode;
+}
+
+void TDS::getCalibration(float &kValue, float &factor)
+{
+    probe.getCalibration(kValue, factor);
+}
+
+void TDS::setCalibration(float kValue, float factor)
+{
+    probe.setCalibration(kValue, factor);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stdint.h>
+#include "WaterTemperature.h"
+#include "SensorInterface.h"
+#include "utils.h"
+#include "AnalogInput.h"
+#include "Filters.h"
+#include "Profiler.h"
+#include "Sensor.h"
+
+/**
+ * @brief TDS probe calibration, based on the DFRobot Gravity TDS driver. The probe
+ *          voltage is compensated to 25 C and gives the EC by the cubic curve of the
+ *          probe, scaled by the k value, the TDS is the EC times the TDS factor
+ */
+class TDSCalibration
+{
+public:
+    // one extra bit by oversampling
+    typedef AnalogInput<1> Input;
+
+    static const uint8_t PROBE = Profiler::TDS_READ;
+
+private:
+    WaterTemperature *waterTemperature = nullptr;
+
+    float kValue = 1.0f;
+    float factor = 0.5f;        // ppm per uS/cm
+
+public:
+    static const char *field() { return "tds"; }
+
+    void setWaterTemperatureSensor(WaterTemperature *sensor);
+
+    template<class Source>
+    float apply(Source &sensor, uint16_t counts)
+    {
+        return convert(counts, compensationTemperature());
+    }
+
+    /**
+     * @brief TDS in ppm of an EC in mS/cm, the EC must already be compensated
+     */
+    float fromEC(float ec) const
+    {
+        return ec * 1000.0f * factor;
+    }
+
+    void getCalibration(float &kValue, float &factor);
+
+    void setCalibration(float kValue, float factor);
+
+    /**
+     * @brief conversion from ADC counts to TDS in ppm
+     *
+     * @param counts ADC counts
+     * @param temperature water temperature in Celsius
+     */
+    float convert(uint16_t counts, float temperature) const;
+
+private:
+    /**
+     * @brief cached water temperature in Celsius, 25 C if there is no valid reading
+     */
+    inline float compensationTemperature()
+    {
+#ifdef USE_WATER_TEMPERATURE
+        return waterTemperature && waterTemperature->valid() ? waterTemperature->readCelsius() : 25.0f;
+#else
+        return 25.0f;
+#endif
+    }
+};
+
+/**
+ * @brief TDS channel, either read from its own probe or derived from the EC channel
+ *
+ * In direct mode the probe on the TDS pin is sampled like the other analog channels.
+ * In derived mode the TDS is computed from the temperature compensated EC that the EC
+ * channel already produced, handed in by updateEC() from the sample path, so it costs
+ * neither an ADC conversion nor a second temperature compensation. The TDS factor of
+ * the calibration applies in both modes.
+ */
+class TDS final : public SensorInterface
+{
+public:
+    enum Mode : uint8_t {
+        DIRECT,
+        DERIVED
+    };
+
+    // a running median rejects spikes like on the other channels
+    typedef Sensor<TDSCalibration::Input, Filters::Median<5>, TDSCalibration> Probe;
+
+private:
+    Probe probe;
+    Mode mode = DIRECT;
+
+    SensorInterface *ecSensor = nullptr;
+    float ec = 0.0f;
+    bool hasEC = false;
+
+public:
+    TDS(uint8_t pin);
+
+    void init() override;
+
+    /**
+     * @brief returns the TDS in ppm
+     *
+     * @param _ unused
+     * @return float reading
+     */
+    float read(uint8_t _=0) override;
+
+    size_t write(char *buffer, uint8_t idx=0) override;
+
+    void setWaterTemperatureSensor(WaterTemperature *sensor);
+
+    /**
+     * @brief EC sensor read by the derived mode before the first updateEC()
+     */
+    void setECSensor(SensorInterface *sensor);
+
+    /**
+     * @brief hands in the latest EC reading for the derived mode
+     *
+     * @param ec temperature compensated EC in mS/cm
+     */
+    void updateEC(float ec);
+
+    Mode getMode() const;
+
+    void setMode(Mode mode);
+
+    void getCalibration(float &kValue, float &factor);
+
+    void setCalibration(float kValue, float factor);
+};
@@ -0,0 +1,16 @@
+#include "Turbidity.h"
+
+#include "Arduino.h"
+#include "utils.h"
+
+void TurbidityCalibration::getCalibration(float &m, float &b)
+{
+    m = this->m;
+    b = this->b;
+}
+
+void TurbidityCalibration::setCalibration(float m, float b)
+{
+    this->m = m;
+    this->b = b;
+}
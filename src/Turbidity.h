@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include "utils.h"
+#include "AnalogInput.h"
+#include "Filters.h"
+#include "Calibrators.h"
+#include "Profiler.h"
+#include "Sensor.h"
+
+/**
+ * @brief Linear turbidity calibration (value = m * raw + b), m and b are defined on
+ *          the 10 bit ADC counts
+ * 
+ */
+class TurbidityCalibration
+{
+public:
+    // two extra bits by oversampling
+    typedef AnalogInput<2> Input;
+
+    static const uint8_t PROBE = Profiler::TURB_READ;
+
+private:
+    float m = 1.0f;
+    float b = 0.0f;
+
+public:
+    static const char *field() { return "turb"; }
+
+    template<class Source>
+    float apply(Source &sensor, uint16_t counts)
+    {
+        return counts / static_cast<float>(1 << Input::EXTRA_BITS) * m + b;
+    }
+
+    float pointScale() const { return 1.0f; }
+
+    void getCalibration(float &m, float &b);
+
+    void setCalibration(float m, float b);
+};
+
+// median of the last 5 samples like the former blocking burst of 5 reads, or an
+// N-point calibration once it has two points
+typedef Sensor<TurbidityCalibration::Input, Filters::Median<5>, Calibrators::Points<TurbidityCalibration> > Turbidity;
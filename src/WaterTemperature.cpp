@@ -1,26 +1,27 @@
 #include "WaterTemperature.h"
 
+#ifdef USE_WATER_TEMPERATURE
+
 #include <stdlib.h>
+#include <Arduino.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
+#include "utils.h"
+#include "SensorInterface.h"
+#include "Profiler.h"
 
-WaterTemperature::WaterTemperature() {}
+WaterTemperature::WaterTemperature()
+{
+    for (uint8_t i = 0; i < MAX_PROBES; ++i) lastCelsius[i] = DEVICE_DISCONNECTED_C;
+}
 
 WaterTemperature::WaterTemperature(uint8_t pin, bool initialize)
     : oneWire(pin), sensor(&oneWire)
 {
+    for (uint8_t i = 0; i < MAX_PROBES; ++i) lastCelsius[i] = DEVICE_DISCONNECTED_C;
+
     if (initialize) {
         init();
-        // sensor.requestTemperatures();
-        // Serial.println();
-        // Serial.println(sensor.getTempFByIndex(0));
-
-        //         sensor.requestTemperatures();
-        // Serial.println();
-        // Serial.println(sensor.getTempFByIndex(0));
-        //         sensor.requestTemperatures();
-        // Serial.println();
-        // Serial.println(sensor.getTempFByIndex(0));
     }
 }
 
@@ -28,18 +29,88 @@ void WaterTemperature::init()
 {
     if (!initialized) {
         sensor.begin();
+
+        // the bus is searched only here, conversions are read back by address
+        probeCount = 0;
+        uint8_t devices = sensor.getDeviceCount();
+        for (uint8_t i = 0; i < devices && probeCount < MAX_PROBES; ++i) {
+            if (sensor.getAddress(addresses[probeCount], i)) ++probeCount;
+        }
+
+        sensor.setWaitForConversion(false);
         initialized = true;
+        requestConversion();
     }
 }
 
+void WaterTemperature::update()
+{
+    PROFILE_SCOPE(TEMP_UPDATE);
+
+    if (!initialized) return;
+
+    if (converting) {
+        if (!sensor.isConversionComplete()) return;
+
+        for (uint8_t i = 0; i < probeCount; ++i) {
+            float celsius = sensor.getTempC(addresses[i]);
+            if (celsius != DEVICE_DISCONNECTED_C) lastCelsius[i] = celsius;
+        }
+        lastTimestamp = millis();
+        converting = false;
+    }
+
+    if (millis() - requestTime >= interval) {
+        requestConversion();
+    }
+}
+
+void WaterTemperature::setInterval(unsigned long ms)
+{
+    interval = ms;
+}
+
+uint8_t WaterTemperature::probes() const
+{
+    return probeCount;
+}
+
 float WaterTemperature::read(uint8_t idx)
 {
-    sensor.requestTemperatures();
-    return sensor.getTempFByIndex(0);
+    return valid(idx) ? DallasTemperature::toFahrenheit(lastCelsius[idx]) : DEVICE_DISCONNECTED_F;
+}
+
+float WaterTemperature::readCelsius(uint8_t idx)
+{
+    return idx < probeCount ? lastCelsius[idx] : DEVICE_DISCONNECTED_C;
+}
+
+bool WaterTemperature::valid(uint8_t idx) const
+{
+    return idx < probeCount && lastCelsius[idx] != DEVICE_DISCONNECTED_C;
+}
+
+unsigned long WaterTemperature::timestamp() const
+{
+    return lastTimestamp;
 }
 
 size_t WaterTemperature::write(char *buffer, uint8_t idx)
 {
-    sprintf(buffer, "%d:%.4f,", idx, read());
-    return strlen(buffer);
+    char name[8] = "temp";
+    if (idx) {
+        Format::BufferPrint suffix(name + 4, sizeof(name) - 4);
+        Format::unsignedInteger(suffix, idx);
+    }
+
+    return Utils::writeField(buffer, SensorInterface::FIELD_SIZE, name, readCelsius(idx));
 }
+
+void WaterTemperature::requestConversion()
+{
+    sensor.requestTemperatures();
+    requestTime = millis();
+    converting = true;
+}
+
+#endif
@@ -2,24 +2,54 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include "utils.h"
+
+class WaterTemperature;
+
+#ifdef USE_WATER_TEMPERATURE
+
 #include <OneWire.h>
 #include <DallasTemperature.h>
 
 /**
- * @brief OneWire Temperature Sensor wrapper
+ * @brief OneWire Temperature Sensor wrapper for any number of DS18B20 probes on one pin
  * 
+ * init() enumerates the bus once and caches the ROM address of every probe, up to
+ * MAX_PROBES. Probe idx is the idx-th device found by the bus search.
+ * 
+ * Conversions are non-blocking. One broadcast conversion is started for all probes,
+ * update() must be called from loop() to collect the results by address once the
+ * conversion finished and to start the next one. read() never touches the 1-Wire bus,
+ * it returns the last cached value.
  */
 class WaterTemperature
 {
 public:
     const char *DEFAULT_ID = "_";
 
+    /**
+     * @brief Minimum time between the start of two conversions in milliseconds
+     */
+    static const unsigned long DEFAULT_INTERVAL = 1000;
+
+    static const uint8_t MAX_PROBES = Board::Current::TEMPERATURE_PROBES;
+
 private:
 
     OneWire oneWire;
     DallasTemperature sensor;
     bool initialized = false;
 
+    uint8_t probeCount = 0;
+    DeviceAddress addresses[MAX_PROBES];
+
+    bool converting = false;
+    unsigned long interval = DEFAULT_INTERVAL;
+    unsigned long requestTime = 0;
+
+    float lastCelsius[MAX_PROBES];
+    unsigned long lastTimestamp = 0;
+
 public:
     /**
      * @brief Unsafe construction of WaterTemperature object
@@ -34,9 +64,68 @@ public:
      */
     WaterTemperature(uint8_t pin, bool initialize);
 
+    /**
+     * @brief enumerates the probes on the bus and starts the first conversion
+     */
     void init();
-    
+
+    /**
+     * @brief number of probes found by init()
+     */
+    uint8_t probes() const;
+
+    /**
+     * @brief Polls the pending conversion. Stores the result once the conversion
+     *          completes and starts the next conversion after the interval elapsed.
+     *          Must be called from loop()
+     */
+    void update();
+
+    /**
+     * @brief Sets the minimum time between two conversions
+     * 
+     * @param ms interval in milliseconds
+     */
+    void setInterval(unsigned long ms);
+
+    /**
+     * @brief returns the cached temperature in Fahrenheit
+     * 
+     * @param idx probe index
+     * @return float last temperature reading, DEVICE_DISCONNECTED_F if there is none
+     */
     float read(uint8_t idx=0);
 
+    /**
+     * @brief returns the cached temperature in Celsius
+     * 
+     * @param idx probe index
+     * @return float last temperature reading, DEVICE_DISCONNECTED_C if there is none
+     */
+    float readCelsius(uint8_t idx=0);
+
+    /**
+     * @brief checks if at least one conversion of the probe finished successfully
+     */
+    bool valid(uint8_t idx=0) const;
+
+    /**
+     * @brief millis() timestamp of the last completed conversion
+     */
+    unsigned long timestamp() const;
+
+    /**
+     * @brief writes the cached Celsius reading of a probe as the record field
+     *          `"temp": value,` for probe 0 and `"tempN": value,` for probe N
+     * 
+     * @param buffer output, at least SensorInterface::FIELD_SIZE bytes
+     * @param idx probe index
+     * @return size_t length of the field
+     */
     size_t write(char *buffer, uint8_t idx);
+
+private:
+    void requestConversion();
 };
+
+#endif
@@ -1,18 +1,103 @@
 #include "EC.h"
 #include "PH.h"
+#include "Turbidity.h"
+#include "TDS.h"
+#include "SampleScheduler.h"
+#include "Commands.h"
+#include "LineReader.h"
+#include "BinaryStream.h"
+#include "AdcCapture.h"
+#include "CalibrationStore.h"
+#include "SampleLog.h"
+#include "Alarms.h"
+#include "StackMonitor.h"
+#include "Profiler.h"
 #include "utils.h"
 #include <Arduino.h>
 
-#define USE_WATER_TEMPERATURE
-
-char buffer[256];
-uint16_t bufferPtr = 0;
-
 // Sensors
 PH ph(A3);
 EC ec(A2);
-const uint8_t turb = A0;
-const uint8_t TDS = A1;
+Turbidity turb(A0);
+TDS tds(A1);
+
+#ifdef USE_ADC_CAPTURE
+const uint8_t CAPTURE_PINS[] = { A0, A1, A2, A3 };
+#endif
+
+// Background sampling
+enum SampleChannel : uint8_t {
+    CHANNEL_PH,
+    CHANNEL_EC,
+    CHANNEL_TURB,
+    CHANNEL_TDS,
+    CHANNEL_COUNT
+};
+
+SensorInterface *const CHANNEL_SENSORS[CHANNEL_COUNT] = { &ph, &ec, &turb, &tds };
+
+const unsigned long PH_SAMPLE_PERIOD   = 100;   // ms
+const unsigned long EC_SAMPLE_PERIOD   = 100;   // ms
+const unsigned long TURB_SAMPLE_PERIOD = 20;    // ms
+const unsigned long TDS_SAMPLE_PERIOD  = 100;   // ms, direct mode, derived TDS follows every EC sample
+
+typedef SampleScheduler<CHANNEL_COUNT, Board::Current::SAMPLE_DEPTH> Sampler;
+Sampler sampler;
+
+// Binary sample stream, started with /stream start
+BinaryStream<CHANNEL_COUNT> binaryStream(Serial);
+
+// Serial commands, a line is complete after 1 s without input even without terminator
+LineReader<Board::Current::LINE_SIZE> lineReader(1000);
+
+// On-device log of all channels, survives host link drops but not resets
+#ifdef USE_WATER_TEMPERATURE
+const uint8_t LOG_CHANNELS = CHANNEL_COUNT + 1;     // water temperature is logged last
+#else
+const uint8_t LOG_CHANNELS = CHANNEL_COUNT;
+#endif
+
+const uint8_t LOG_LINE_SIZE = 56;                   // longest expected /log line
+
+SampleLog<Board::Current::LOG_SIZE, LOG_CHANNELS> sampleLog;
+unsigned long logPeriod = 10000;                    // ms, 0 disables logging
+unsigned long lastLogTime = 0;
+
+// Fields of the /all and /read record, in record order
+enum RecordField : uint8_t {
+    FIELD_PH,
+    FIELD_EC,
+    FIELD_TURB,
+    FIELD_TDS,
+    FIELD_TEMP,
+    FIELD_COUNT
+};
+
+const char FIELD_PH_NAME[] PROGMEM   = "ph";
+const char FIELD_EC_NAME[] PROGMEM   = "ec";
+const char FIELD_TURB_NAME[] PROGMEM = "turb";
+const char FIELD_TDS_NAME[] PROGMEM  = "tds";
+const char FIELD_TEMP_NAME[] PROGMEM = "temp";
+
+const char *const FIELD_NAMES[FIELD_COUNT] PROGMEM = {
+    FIELD_PH_NAME, FIELD_EC_NAME, FIELD_TURB_NAME, FIELD_TDS_NAME, FIELD_TEMP_NAME
+};
+
+// Threshold alarms per sample channel, pushed as unsolicited /alarm lines. Channels
+// are named by their record field
+Alarms<CHANNEL_COUNT> alarms;
+
+const uint8_t ALARM_LINE_SIZE = 32;                 // longest expected /alarm event line
+
+static_assert(static_cast<uint8_t>(FIELD_PH) == CHANNEL_PH && static_cast<uint8_t>(FIELD_EC) == CHANNEL_EC
+              && static_cast<uint8_t>(FIELD_TURB) == CHANNEL_TURB && static_cast<uint8_t>(FIELD_TDS) == CHANNEL_TDS,
+              "sample channels must be the first record fields");
+static_assert(CHANNEL_COUNT == CalibrationData::ALARM_CHANNELS, "the calibration record holds one alarm per sample channel");
+
+// Calibration persisted across resets
+#ifdef USE_CALIBRATION_STORE
+CalibrationStore calibrationStore;
+#endif
 
 // Water Temperature
 #ifdef USE_WATER_TEMPERATURE
@@ -20,488 +105,907 @@ WaterTemperature waterTemperature(1, false);
 #endif
 
 /**
- * @brief Checks if a string contains the following sequence "\r\n". This function
- *          returns the first index where this sequence is found (specifically the
- *          index of '\r'). If not found, -1 is returned.
+ * @brief Returns the latest reading of a channel from its sample buffer. Samples are
+ *          already filtered by the sensor. Reads the sensor directly if no sample has
+ *          been buffered yet
  * 
- * @param str The string to process
- * @param start The starting index
- * @param size The size of the buffer
- * @return int The index where the first sequence "\r\n" is found. -1 is return if
- *          not found
+ * @param channel sampler channel of the sensor
+ * @param sensor sensor of the channel
+ * @return float latest filtered sample
  */
-int scanForTerminator(const char *str, size_t start=0, size_t size=-1)
+float filteredRead(uint8_t channel, SensorInterface &sensor)
 {
-    for (size_t i = start; i < size - 1 && str[i] != 0; ++i) {
+    const Sampler::Buffer &samples = sampler.samples(channel);
+    return samples.empty() ? sensor.read() : samples.latest();
+}
 
-        if (str[i] == '\r' && str[i+1] == '\n') return i;
+/**
+ * @brief Sends the pending alarm event of a channel as
+ * 
+ *      /alarm <channel> low|high|clear <sample>
+ * 
+ * @param channel sample channel
+ * @param wait wait for room in the transmit buffer, else the event stays pending
+ *          while the line does not fit
+ */
+void sendAlarm(uint8_t channel, bool wait)
+{
+    if (!wait && Serial.availableForWrite() < ALARM_LINE_SIZE) return;
+
+    Alarms<CHANNEL_COUNT>::State state;
+    float value;
+    if (!alarms.take(channel, state, value)) return;
+
+    Serial.print(F("/alarm "));
+    Serial.print((const __FlashStringHelper *) pgm_read_ptr(&FIELD_NAMES[channel]));
+    switch (state) {
+    case Alarms<CHANNEL_COUNT>::BELOW: Serial.print(F(" low "));   break;
+    case Alarms<CHANNEL_COUNT>::ABOVE: Serial.print(F(" high "));  break;
+    default:                           Serial.print(F(" clear ")); break;
     }
+    Format::decimal<2>(Serial, value);
+    Serial.println();
+}
 
-    return -1;
+/**
+ * @brief Sends the alarm events that did not fit into the transmit buffer when they
+ *          occurred
+ */
+void updateAlarms()
+{
+    for (uint8_t i = 0; i < CHANNEL_COUNT; ++i) sendAlarm(i, false);
 }
 
-int nextWord(const char *str,
-              size_t str_size,
-              char *buffer,
-              size_t buffer_size,
-              size_t start,
-              size_t end=-1
-              )
+/**
+ * @brief Sample path, called by the sampler for every new sample
+ */
+void onSample(uint8_t channel, float value, unsigned long now)
 {
-    auto isDelimiter = [](char c) {
-        return c == '\r' || c == '\n' || c == ' ';
-    };
+    binaryStream.publish(channel, value, now);
 
-    end = min(str_size, end);
+    // an event still waiting for the transmit buffer must not be replaced by the next
+    if (alarms.pending(channel)) sendAlarm(channel, true);
+    if (alarms.update(channel, value)) sendAlarm(channel, false);
 
-    // moves pointer to white space
-    while (isDelimiter(str[start]) && start < end) {
-        ++start;
+    // the derived TDS is a sample of the same EC reading, not a channel of its own
+    if (channel == CHANNEL_EC) {
+        tds.updateEC(value);
+        if (tds.getMode() == TDS::DERIVED) sampler.record(CHANNEL_TDS, tds.read(), now);
     }
-    
-    // begins scanning for delimiter
-    size_t i = start;
-    while (i < end && str[i] != 0) {
-        ++i;
+}
+
+/**
+ * @brief Samples the TDS channel on its own in direct mode. In derived mode onSample()
+ *          records it with every EC sample instead
+ */
+void scheduleTds()
+{
+    if (tds.getMode() == TDS::DIRECT) sampler.attach(CHANNEL_TDS, &tds, TDS_SAMPLE_PERIOD);
+    else sampler.detach(CHANNEL_TDS);
+}
+
+/**
+ * @brief Applies the stored calibration to the sensors. The sensors keep their
+ *          defaults if there is no valid record
+ */
+void loadCalibration()
+{
+#ifdef USE_CALIBRATION_STORE
+    CalibrationData data;
+    if (!calibrationStore.load(data)) {
+        Serial.println(F("-> No stored calibration, using defaults"));
+        return;
     }
 
-    memcpy(buffer, str + start, min(i - start, buffer_size));
+    ph.setCalibration(data.phNeutral, data.phAcid);
+    ec.setCalibration(data.ecLow, data.ecHigh);
+    turb.setCalibration(data.turbM, data.turbB);
+    tds.setCalibration(data.tdsK, data.tdsFactor);
+    tds.setMode(static_cast<TDS::Mode>(data.tdsMode));
+    ph.setCalibrationPoints(data.phTable);
+    ec.setCalibrationPoints(data.ecTable);
+    turb.setCalibrationPoints(data.turbTable);
+    for (uint8_t i = 0; i < CHANNEL_COUNT; ++i) {
+        const CalibrationData::Alarm &alarm = data.alarms[i];
+        if (alarm.enabled) alarms.set(i, alarm.low, alarm.high, alarm.hysteresis);
+    }
+    Serial.println(F("-> Calibration loaded"));
+#endif
+}
 
-    return ++i; // returns the pointer to the next character
+/**
+ * @brief Stores the calibration of all sensors and the alarm limits, called after every
+ *          calibration or alarm change
+ */
+void saveCalibration()
+{
+#ifdef USE_CALIBRATION_STORE
+    CalibrationData data;
+    ph.getCalibration(data.phNeutral, data.phAcid);
+    ec.getCalibration(data.ecLow, data.ecHigh);
+    turb.getCalibration(data.turbM, data.turbB);
+    tds.getCalibration(data.tdsK, data.tdsFactor);
+    data.tdsMode = tds.getMode();
+    data.phTable = ph.getCalibrationPoints().points();
+    data.ecTable = ec.getCalibrationPoints().points();
+    data.turbTable = turb.getCalibrationPoints().points();
+    for (uint8_t i = 0; i < CHANNEL_COUNT; ++i) {
+        CalibrationData::Alarm &alarm = data.alarms[i];
+        alarm.enabled = alarms.enabled(i);
+        alarms.get(i, alarm.low, alarm.high, alarm.hysteresis);
+    }
+
+    if (!calibrationStore.save(data)) {
+        Serial.println(F("/err: Calibration could not be saved"));
+    }
+#endif
 }
 
-bool echo(const char *command, size_t size)
+/**
+ * @brief Appends a snapshot of the latest sample of every channel to the log once
+ *          per log period
+ */
+void updateLog(unsigned long now)
 {
-    char word[32] = { 0 };
-    size_t ptr = nextWord(command, size, word, sizeof(word), 0);
+    if (!logPeriod || now - lastLogTime < logPeriod) return;
+    lastLogTime = now;
+
+    float values[LOG_CHANNELS];
+    values[CHANNEL_PH] = filteredRead(CHANNEL_PH, ph);
+    values[CHANNEL_EC] = filteredRead(CHANNEL_EC, ec);
+    values[CHANNEL_TURB] = filteredRead(CHANNEL_TURB, turb);
+    values[CHANNEL_TDS] = filteredRead(CHANNEL_TDS, tds);
+#ifdef USE_WATER_TEMPERATURE
+    values[CHANNEL_COUNT] = waterTemperature.readCelsius();
+#endif
 
-    if (strcmp("/echo", word)) return false;
+    sampleLog.append(now, values);
+}
+
+/**
+ * @brief Sends the next record of a running /log dump, one per loop() pass and only
+ *          if the line fits into the transmit buffer
+ */
+void updateLogDump()
+{
+    if (!sampleLog.dumping() || Serial.availableForWrite() < LOG_LINE_SIZE) return;
 
-    char message[64];
-    strncpy(message, command + ptr, min(sizeof(message), size - ptr));
-    Serial.print("/echo: ");
-    Serial.print(message);
-    Serial.print("\r\n");
+    unsigned long time;
+    float values[LOG_CHANNELS];
+    if (!sampleLog.next(time, values)) {
+        Serial.println(F("/log end"));
+        return;
+    }
 
-    return true;
+    Serial.print(F("/log "));
+    Serial.print(time);
+    for (uint8_t i = 0; i < LOG_CHANNELS; ++i) {
+        Serial.print(' ');
+        Format::decimal<2>(Serial, values[i]);
+    }
+    Serial.println();
 }
 
-uint8_t help(const char *command, size_t size)
+/**
+ * @brief Sends one record with a field for every channel in the mask. The channels
+ *          report their latest buffered sample, so a record neither takes conversions
+ *          nor advances the filters of the sample path. The temp field reads the
+ *          cached water temperature conversion
+ * 
+ * @param fields bit mask of RecordField
+ */
+void writeRecord(uint8_t fields)
 {
-    char nxtWord[32] = { 0 };
-    int ptr = nextWord(command, size, nxtWord, sizeof(nxtWord), 0);
-    if (!ptr || strcmp(nxtWord, "/help")) {
-        return false;
+    char field[SensorInterface::FIELD_SIZE];
+    char name[8];
+    bool first = true;
+
+    Serial.print(F("/read {"));
+    for (uint8_t i = 0; i < FIELD_COUNT; ++i) {
+        if (!(fields & (1 << i))) continue;
+
+        // the temp field expands to one field per probe
+        uint8_t count = 1;
+#ifdef USE_WATER_TEMPERATURE
+        if (i == FIELD_TEMP) count = waterTemperature.probes();
+#endif
+
+        for (uint8_t idx = 0; idx < count; ++idx) {
+            size_t length = 0;
+            if (i < CHANNEL_COUNT) {
+                strcpy_P(name, (const char *) pgm_read_ptr(&FIELD_NAMES[i]));
+                length = Utils::writeField(field, sizeof(field), name, filteredRead(i, *CHANNEL_SENSORS[i]));
+            }
+#ifdef USE_WATER_TEMPERATURE
+            else if (i == FIELD_TEMP) {
+                length = waterTemperature.write(field, idx);
+            }
+#endif
+            if (!length) continue;
+
+            // the record has its own separators, a field cut off by the buffer has none
+            if (field[length - 1] == ',') field[length - 1] = '\0';
+            if (!first) Serial.print(F(", "));
+            Serial.print(field);
+            first = false;
+        }
     }
+    Serial.println('}');
 }
 
-// @deprecated
-/*
-uint8_t phCommand(const char *command, size_t size)
+/**
+ * @brief Shared handlers of the N-point calibration commands of ph, ec and turb
+ * 
+ * @param prefix response prefix, e.g. "/ph"
+ * @param channel sampler channel of the sensor
+ */
+template<class SensorType>
+void calibrationPointAdd(SensorType &sensor, const __FlashStringHelper *prefix, uint8_t channel, float value)
 {
-    char nxtWord[32] = { 0 };
-    int ptr = nextWord(command, size, nxtWord, sizeof(nxtWord), 0);
-    if (strcmp(nxtWord, "/ph")) return false;
+    Serial.print(prefix);
+    if (!sensor.addCalibrationPoint(value)) {
+        Serial.println(F(" calibration points full"));
+        return;
+    }
+    sampler.clear(channel);
+    saveCalibration();
+    Serial.print(F(" calibration point "));
+    Serial.print(sensor.getCalibrationPoints().size());
+    Serial.print('/');
+    Serial.println(SensorType::PointCalibration::capacity());
+}
 
-    char number[16];
-    sprintf(number, "/res ph %.4f\r\n");
-    Serial.print(number);
+template<class SensorType>
+void calibrationPointList(SensorType &sensor, const __FlashStringHelper *prefix)
+{
+    const typename SensorType::PointCalibration &points = sensor.getCalibrationPoints();
+
+    Serial.print(prefix);
+    Serial.print(F(" calibration points"));
+    for (uint8_t i = 0; i < points.size(); ++i) {
+        Serial.print(' ');
+        Serial.print(points[i].counts);
+        Serial.print(':');
+        Format::decimal<3>(Serial, points[i].value);
+    }
+    Serial.println();
 }
-*/
 
-void setup()
+template<class SensorType>
+void calibrationPointClear(SensorType &sensor, const __FlashStringHelper *prefix, uint8_t channel)
 {
-    // put your setup code here, to run once:
-    Serial.begin(9600);
-    Serial.println("-> Initialized");
+    sensor.clearCalibrationPoints();
+    sampler.clear(channel);
+    saveCalibration();
+    Serial.print(prefix);
+    Serial.println(F(" calibration points cleared"));
+}
 
-#ifdef USE_WATER_TEMPERATURE
-    waterTemperature.init();
-    ec.setWaterTemperatureSensor(&waterTemperature);    
-#endif
+/**
+ * Command handlers. Arguments are validated against the schema of the command table
+ * before a handler is called
+ */
+void flushCommand(char **args, uint8_t argc)
+{
+    Serial.flush();
+}
 
+void echoCommand(char **args, uint8_t argc)
+{
+    Serial.print(F("/echo "));
+    if (argc) Serial.print(args[0]);
+    Serial.print(F("\r\n"));
 }
 
-void loop()
+void phRead(char **args, uint8_t argc)
 {
-    if (Serial.available()) {
+    Serial.print(F("/ph "));
+    Format::decimal<2>(Serial, filteredRead(CHANNEL_PH, ph));
+    Serial.println();
+}
 
-        char c = Serial.read();
+void phCalibrateStart(char **args, uint8_t argc)
+{
+    Serial.print(F("/ph calibrate start\r\n"));
+
+    // Get the current ph calibration values.
+    // Then start the ph calibration.
+    // Then check which ph calibration value changed.
+    // Print to the serial which ph setting is changed, the old value, and the new value
+    float old_neutral_voltage, old_acid_voltage;
+    ph.getCalibration(old_neutral_voltage, old_acid_voltage);
+    ph.calibrate();
+    sampler.clear(CHANNEL_PH);
+    saveCalibration();
+
+    float new_neutral_voltage, new_acid_voltage;
+    ph.getCalibration(new_neutral_voltage, new_acid_voltage);
+
+    if (old_neutral_voltage != new_neutral_voltage) {
+        Serial.print(F("/ph: calibration neutral from "));
+        Format::decimal<4>(Serial, old_neutral_voltage);
+        Serial.print(F(" to "));
+        Format::decimal<4>(Serial, new_neutral_voltage);
+        Serial.println();
+    }
+    else if (old_acid_voltage != new_acid_voltage) {
+        Serial.print(F("/ph: calibration acid from "));
+        Format::decimal<4>(Serial, old_acid_voltage);
+        Serial.print(F(" to "));
+        Format::decimal<4>(Serial, new_acid_voltage);
+        Serial.println();
+    }
+    else {
+        Serial.println(F("/ph: calibration values unchanged"));
+    }
 
-        // do nothing if it doesn't start with a backslash
-        if (c != '/') {
-            return;
-        }
+    Serial.println(F("/ph calibration end"));
+}
 
-        // how long the program waits for input until it processes the incoming data
-        const long timeout = 1000;
+void phCalibrateGet(char **args, uint8_t argc)
+{
+    float neutralVoltage, acidVoltage;
+    ph.getCalibration(neutralVoltage, acidVoltage);
+    Serial.print(F("/ph calibration data "));
+    Format::decimal<2>(Serial, neutralVoltage);
+    Serial.print(' ');
+    Format::decimal<2>(Serial, acidVoltage);
+    Serial.println();
+}
 
-        char c_input[64] = { '\0' };        // The '\0' indicates the end of the string. To make it easy for us, the whole c-string is set to \0
-        long start = millis();
-        size_t bytesBufferRead = 0;
-        do {
+void phCalibrateSet(char **args, uint8_t argc)
+{
+    if (!ph.setCalibration(atof(args[0]), atof(args[1]))) {
+        Serial.println(F("/err: Invalid arguments"));
+        return;
+    }
+    sampler.clear(CHANNEL_PH);
+    saveCalibration();
+    Serial.println(F("/ph calibration set success"));
+}
 
-            int c = Serial.read();
-            if (c >= 0) {
+void ecRead(char **args, uint8_t argc)
+{
+    Serial.print(F("/ec "));
+    Format::decimal<2>(Serial, filteredRead(CHANNEL_EC, ec));
+    Serial.println();
+}
 
-                if (c == '\r' || c == '\n') {
-                    break;
-                }
-                else if (bytesBufferRead == sizeof(c_input) - 1) {  // a c-string must end with a '\0'. This ensures that if c_input has 64 bytes
-                                                                    // of space, the object can only accept at most 63 characters + 1 character for
-                                                                    // the '\0' character
+void phCalibratePoint(char **args, uint8_t argc)
+{
+    calibrationPointAdd(ph, F("/ph"), CHANNEL_PH, atof(args[0]));
+}
 
-                    char output[64];
-                    // sprintf(output, "/err: Too many characters received. Maximum command must be %d characters\r\n", sizeof(c_input) - 1);
-                    Serial.print(output);
-                    return;
-                }
+void phCalibratePoints(char **args, uint8_t argc)
+{
+    calibrationPointList(ph, F("/ph"));
+}
 
-                c_input[bytesBufferRead++] = c;
-                start = millis();
-            }
-        } while (millis() - start < timeout);
-        
-        {
-            char output[128];
-            sprintf(output, "-> The command received: \"%s\"\n", c_input);
-            Serial.print(output);
-        }
+void phCalibrateClear(char **args, uint8_t argc)
+{
+    calibrationPointClear(ph, F("/ph"), CHANNEL_PH);
+}
 
-        /**
-         * Read remaing string
-         * Get the first word of the string
-         */
-        // char c_input[64] = { 0 };
-        // {
-        //     String input = Serial.readStringUntil('\r');
-
-        //     if (input.length() > sizeof(c_input)) {
-        //         char output[32];
-        //         sprintf(output, "/err: Input too long. Can only read %d characters\r\n", sizeof(c_input));
-        //         Serial.print(output);
-        //         return;
-        //     }
-            
-        //     input.toCharArray(c_input, sizeof(c_input));
-        // }
-
-        const char SPLITTER[] = " \n\r";
-        char *pch = strtok(c_input, SPLITTER);
-        
-        if (pch == nullptr) {
-            Serial.println(F("/err: Invalid command"));
-            return;
-        }
+void ecCalibrateStart(char **args, uint8_t argc)
+{
+    Serial.print(F("/ec calibrate start\r\n"));
+
+    float old_low_value, old_high_value;
+    ec.getCalibration(old_low_value, old_high_value);
+    ec.calibrate();
+    sampler.clear(CHANNEL_EC);
+    saveCalibration();
+
+    float new_low_value, new_high_value;
+    ec.getCalibration(new_low_value, new_high_value);
+
+    if (old_low_value != new_low_value) {
+        Serial.print(F("/ec: calibration low from "));
+        Format::decimal<4>(Serial, old_low_value);
+        Serial.print(F(" to "));
+        Format::decimal<4>(Serial, new_low_value);
+        Serial.println();
+    }
+    else if (old_high_value != new_high_value) {
+        Serial.print(F("/ec: calibration high from "));
+        Format::decimal<4>(Serial, old_high_value);
+        Serial.print(F(" to "));
+        Format::decimal<4>(Serial, new_high_value);
+        Serial.println();
+    }
+    else {
+        Serial.println(F("/ec: calibration values unchanged"));
+    }
 
-        // if pch is equal to "flush", flush the buffer
-        if (strcmp(pch, "flush") == 0) {
-            Serial.flush();
-        }
-        else if (strcmp(pch, "echo") == 0) {
-            Serial.print("/echo ");
-            
-            if (strtok(nullptr, SPLITTER) == nullptr) {
-                Serial.print(c_input + 6);
-                Serial.print("\r\n");
-                return;
-            }
-        }
-        else if (strcmp(pch, "ph") == 0) {
+    Serial.println(F("/ec calibration end"));
+}
 
-            pch = strtok(nullptr, SPLITTER);
-            if (pch == nullptr) {
-                double phVal = ph.read();
-                Serial.print("/ph ");
-                Serial.println(phVal);
-            }
-            else {
-
-                // if pch is equal to "calibrate", calibrate the sensor
-                if (strcmp(pch, "calibrate") == 0) {
-                
-                    pch = strtok(nullptr, SPLITTER);
-                    // if pch is equal to "start", start the calibration
-                    // else if pch is equal to "get", get the calibration value
-                    // else if pch is equal to "set", set the calibration value with the neutral voltage and acid voltage
-                    // else the command is invalid
-                    if (pch == nullptr) {
-                        Serial.println(F("/err: ph calibrate - unknown command"));
-                        return;
-                    }
-                    else if (strcmp(pch, "start") == 0) {
-
-                        Serial.print(F("/ph calibrate start\r\n"));
-
-                        // MARKER
-
-                        // Get the current ph calibration values.
-                        // Then start the ph calibration.
-                        // Then check which ph calibration value changed.
-                        // Print to the serial which ph setting is changed, the old value, and the new value
-                        float old_neutral_voltage, old_acid_voltage;
-                        ph.getCalibration(old_neutral_voltage, old_acid_voltage);
-                        ph.calibrate();
-                        
-                        float new_neutral_voltage, new_acid_voltage;
-                        ph.getCalibration(new_neutral_voltage, new_acid_voltage);
-
-
-                        char output[128];
-                        if (old_neutral_voltage != new_neutral_voltage) {
-                            sprintf(output, "/ph: calibration neutral from %.4f to %.4f\r\n", old_neutral_voltage, new_neutral_voltage);
-                            Serial.print(output);
-                        }
-                        else if (old_acid_voltage != new_acid_voltage) {
-                            sprintf(output, "/ph: calibration acid from %.4f to %.4f\r\n", old_acid_voltage, new_acid_voltage);
-                            Serial.print(output);
-                        }
-                        else {
-                            Serial.println(F("/ph: calibration values unchanged"));
-                        }
-
-                        Serial.println(F("/ph calibration end\r\n"));
-                    }
-                    else if (strcmp(pch, "get") == 0) {
-                        char output[64];
-                        float neutralVoltage, acidVoltage;
-                        ph.getCalibration(neutralVoltage, acidVoltage);
-                        Serial.print(output);
-                        Serial.print(F("/ph calibration data "));
-                        Serial.print(neutralVoltage);
-                        Serial.print(" ");
-                        Serial.println(acidVoltage);
-                    }
-                    else if (strcmp(pch, "set") == 0) {
-                        pch = strtok(nullptr, SPLITTER);
-                        if (pch == nullptr) {
-                            Serial.println(F("/err: ph calibration set missing neutral voltage"));
-                            return;
-                        }
-
-                        float neutral = atof(pch);
-                        pch = strtok(nullptr, SPLITTER);
-                        if (pch == nullptr) {
-                            Serial.println(F("/err: ph calibration set missing acid voltage"));
-                            return;
-                        }
-
-                        float acid = atof(pch);
-                        ph.setCalibration(neutral, acid);
-                        Serial.println(F("/ph calibration set success"));
-                    }
-                    else {
-                        Serial.println(F("/err: Invalid command"));
-                        return;
-                    }
-                }
-                else {
-                    Serial.print(F("/err: Invalid command"));
-                }
-            }
-        }
-        else if (strcmp(pch, "ec") == 0) {
-            
-            pch = strtok(nullptr, SPLITTER);
-
-            // if pch is null, print the current ec value
-            // else if pch is equal to "calibrate", start the ec calibration
-            // else if pch is equal to "get", get the ec calibration value
-            // else if pch is equal to "set", set the ec calibration value with the neutral voltage and acid voltage
-            // else the command is invalid
-            if (pch == nullptr) {
-                float ecVal = ec.read();
-                Serial.print("/ec ");
-                Serial.println(ecVal);
-            }
-            else if (strcmp(pch, "calibrate") == 0) {
-                
-                pch = strtok(nullptr, SPLITTER);
-                // if pch is equal to "start", start the calibration
-                // else if pch is equal to "get", get the calibration value
-                // else if pch is equal to "set", set the calibration value with the neutral voltage and acid voltage
-                // else the command is invalid
-                if (pch == nullptr) {
-                    Serial.println("/err: ec calibrate - must specify mode");
-                    return;
-                }
-                else if (strcmp(pch, "start") == 0) {
-
-                    {
-                        char output[32];
-                        sprintf(output, "/ec calibrate start\r\n");
-                        Serial.print(output);
-                    }
-
-                    float old_low_value, old_high_value;
-                    ec.getCalibration(old_low_value, old_high_value);
-                    ec.calibrate();
-
-                    float new_low_value, new_high_value;
-                    ec.getCalibration(new_low_value, new_high_value);
-
-                    if (old_low_value != new_low_value) {
-                        char output[128];
-                        sprintf(output, "/ec: calibration low from %.4f to %.4f\r\n", old_low_value, new_low_value);
-                    }
-                    else if (old_high_value != new_high_value) {
-                        char output[128];
-                        sprintf(output, "/ec: calibration high from %.4f to %.4f\r\n", old_high_value, new_high_value);
-                    }
-                    else {
-                        char output[128];
-                        sprintf(output, "/ec: calibration values unchanged\r\n");
-                    }
-
-                    {
-                        char output[32];
-                        sprintf(output, "/ec calibration end\r\n");
-                        Serial.print(output);
-                    }
-                }
-                else if (strcmp(pch, "get") == 0) {
-                    char output[64];
-                    float low, high;
-                    ec.getCalibration(low, high);
-                    sprintf(output, "/ec calibration data %.4f %.4f\r\n", low, high);
-                    Serial.print(output);
-                }
-                else if (strcmp(pch, "set") == 0) {
-
-                    pch = strtok(nullptr, SPLITTER);
-                    if (pch == nullptr) {
-                        Serial.println("/err: ec calibration set missing two parameters");
-                        return;
-                    }
-
-                    float low = atoi(pch);
-                    pch = strtok(nullptr, SPLITTER);
-                    if (pch == nullptr) {
-                        Serial.println("/err: ec calibration set missing one parameter");
-                        return;
-                    }
-
-                    float high = atoi(pch);
-                    if (high < low) Utils::swap(low, high);
-                    ec.setCalibration(low, high);
-                    Serial.println("/ec calibration set success");
-                }
-            }
-        }
-        else if (strcmp(pch, "turb") == 0) {
+void ecCalibrateGet(char **args, uint8_t argc)
+{
+    float low, high;
+    ec.getCalibration(low, high);
+    Serial.print(F("/ec calibration data "));
+    Format::decimal<4>(Serial, low);
+    Serial.print(' ');
+    Format::decimal<4>(Serial, high);
+    Serial.println();
+}
 
-            static float m = 1.0f;
-            static float b = 0.0f;
+void ecCalibrateSet(char **args, uint8_t argc)
+{
+    float low = atof(args[0]);
+    float high = atof(args[1]);
+    if (high < low) Utils::swap(low, high);
+    ec.setCalibration(low, high);
+    sampler.clear(CHANNEL_EC);
+    saveCalibration();
+    Serial.println(F("/ec calibration set success"));
+}
 
-            pch = strtok(nullptr, SPLITTER);
+void ecCalibratePoint(char **args, uint8_t argc)
+{
+    calibrationPointAdd(ec, F("/ec"), CHANNEL_EC, atof(args[0]));
+}
 
-            if (!pch) {
+void ecCalibratePoints(char **args, uint8_t argc)
+{
+    calibrationPointList(ec, F("/ec"));
+}
 
-                float turbidity = analogRead(turb);
-                float turbidityValues[5];
-                for (float &val : turbidityValues) {
-                    delay(20);
-                    val = analogRead(turb);
-                }
+void ecCalibrateClear(char **args, uint8_t argc)
+{
+    calibrationPointClear(ec, F("/ec"), CHANNEL_EC);
+}
 
-                // sort the values
-                for (int i = 0; i < sizeof(turbidityValues) / sizeof(turbidityValues[0]) - 1; ++i) {
+void turbRead(char **args, uint8_t argc)
+{
+    Serial.print(F("/turb "));
+    Format::decimal<2>(Serial, filteredRead(CHANNEL_TURB, turb));
+    Serial.println();
+}
 
-                    int smallestIdx = i;
-                    for (int j = i + 1; j < sizeof(turbidityValues) / sizeof(turbidityValues[0]); ++j) {
+void turbCalibrateGet(char **args, uint8_t argc)
+{
+    float m, b;
+    turb.getCalibration(m, b);
+    Serial.print(F("/turb calibration data m:"));
+    Format::decimal<2>(Serial, m);
+    Serial.print(F(" b:"));
+    Format::decimal<2>(Serial, b);
+    Serial.println();
+}
 
-                        if (turbidityValues[j] < turbidityValues[smallestIdx]) smallestIdx = j;
-                    }
+void turbCalibrateSet(char **args, uint8_t argc)
+{
+    turb.setCalibration(atof(args[0]), atof(args[1]));
+    sampler.clear(CHANNEL_TURB);
+    saveCalibration();
+    Serial.println(F("/turb calibration set success"));
+}
 
-                    Utils::swap(turbidityValues[i], turbidityValues[smallestIdx]);
-                }
+void turbCalibratePoint(char **args, uint8_t argc)
+{
+    calibrationPointAdd(turb, F("/turb"), CHANNEL_TURB, atof(args[0]));
+}
 
-                Serial.print(F("/turb "));
-                Serial.println(turbidityValues[2] * m + b);
-            }
-            else {
-
-                if (!strcmp(pch, "calibrate")) {
-                    
-                    pch = strtok(nullptr, SPLITTER);
-
-                    if (!strcmp(pch, "set")) {
-
-                        pch = strtok(nullptr, SPLITTER);
-                        if (!pch) {
-                            Serial.println(F("/err: turb calibration set missing slope and base"));
-                            return;
-                        }
-                        float mNew = atof(pch);
-                        
-                        pch = strtok(nullptr, SPLITTER);
-                        if (!pch) {
-                            Serial.println(F("/err: turb calibration set missing base"));
-                            return;
-                        }
-                        
-                        b = atof(pch);
-                        m = mNew;
-                    }
-                    else if (!strcmp(pch, "get")) {
-
-                        char output[64];
-                        Serial.print("/turb calibration data m:");
-                        Serial.print(m);
-                        Serial.print(" b:");
-                        Serial.println(b);
-                    }
-                }
-                else if (!strcmp(pch, "help")) {
-
-                    Serial.println("/turb Turbidity list of commands");
-                    Serial.println("/turb           - show the turbidity value");
-                    Serial.println("/turb calibrate - calibrate the turbidity sensor");
-                    Serial.println("/turb help      - show this help");
-                }
-                else {
-                    Serial.println("/err: turb invalid command");
-                }
-            }
-        }
+void turbCalibratePoints(char **args, uint8_t argc)
+{
+    calibrationPointList(turb, F("/turb"));
+}
+
+void turbCalibrateClear(char **args, uint8_t argc)
+{
+    calibrationPointClear(turb, F("/turb"), CHANNEL_TURB);
+}
+
+void turbHelp(char **args, uint8_t argc)
+{
+    Serial.println(F("/turb Turbidity list of commands"));
+    Serial.println(F("/turb                       - show the turbidity value"));
+    Serial.println(F("/turb calibrate get         - show the slope and base"));
+    Serial.println(F("/turb calibrate set <m> <b> - set the slope and base"));
+    Serial.println(F("/turb calibrate point <ntu> - add a point from the current reading"));
+    Serial.println(F("/turb calibrate points      - list the points as counts:ntu"));
+    Serial.println(F("/turb calibrate clear       - remove all points"));
+    Serial.println(F("/turb help                  - show this help"));
+}
+
+void tdsRead(char **args, uint8_t argc)
+{
+    Serial.print(F("/tds "));
+    Format::decimal<2>(Serial, filteredRead(CHANNEL_TDS, tds));
+    Serial.println();
+}
+
+void tdsCalibrateGet(char **args, uint8_t argc)
+{
+    float kValue, factor;
+    tds.getCalibration(kValue, factor);
+    Serial.print(F("/tds calibration data "));
+    Format::decimal<4>(Serial, kValue);
+    Serial.print(' ');
+    Format::decimal<4>(Serial, factor);
+    Serial.println();
+}
+
+void tdsCalibrateSet(char **args, uint8_t argc)
+{
+    tds.setCalibration(atof(args[0]), atof(args[1]));
+    sampler.clear(CHANNEL_TDS);
+    saveCalibration();
+    Serial.println(F("/tds calibration set success"));
+}
+
+void tdsMode(char **args, uint8_t argc)
+{
+    if (argc) {
+        if (!strcmp_P(args[0], PSTR("direct")))       tds.setMode(TDS::DIRECT);
+        else if (!strcmp_P(args[0], PSTR("derived"))) tds.setMode(TDS::DERIVED);
         else {
-            Serial.print("/err: Invalid command\r\n");
+            Serial.print(F("/err: Unknown tds mode "));
+            Serial.println(args[0]);
+            return;
         }
+        scheduleTds();
+        saveCalibration();
+    }
+
+    Serial.print(F("/tds mode "));
+    Serial.println(tds.getMode() == TDS::DERIVED ? F("derived") : F("direct"));
+}
+
+void tempRead(char **args, uint8_t argc)
+{
+#ifdef USE_WATER_TEMPERATURE
+    Serial.print(F("/temp"));
+    for (uint8_t i = 0; i < waterTemperature.probes(); ++i) {
+        Serial.print(' ');
+        Format::decimal<2>(Serial, waterTemperature.readCelsius(i));
+    }
+    Serial.println();
+#else
+    Serial.println(F("/err: No temperature sensor"));
+#endif
+}
+
+void allRead(char **args, uint8_t argc)
+{
+    writeRecord((1 << FIELD_COUNT) - 1);
+}
+
+void batchRead(char **args, uint8_t argc)
+{
+    if (!argc) {
+        allRead(args, argc);
+        return;
     }
-    
-/*     if (Serial.available()) {
-        size_t init_bufferPtr = bufferPtr;
-        bufferPtr += Serial.readBytesUntil('\n', buffer + bufferPtr, sizeof(buffer) - bufferPtr);
-
-        // if exactly two, then flush output and flush buffer
-        if (bufferPtr == 2) {
-            
-            Serial.flush();
-            memset(buffer, 0, sizeof(buffer));
-            bufferPtr = 0;
+
+    uint8_t fields = 0;
+    for (uint8_t i = 0; i < argc; ++i) {
+        uint8_t field = 0;
+        while (field < FIELD_COUNT
+               && strcmp_P(args[i], (const char *) pgm_read_ptr(&FIELD_NAMES[field]))) {
+            ++field;
         }
-        // not enough bytes to process
-        else if (bufferPtr < 2) {
+
+        if (field == FIELD_COUNT) {
+            Serial.print(F("/err: Unknown channel "));
+            Serial.println(args[i]);
             return;
         }
-        // check if last two characters contain the termination sequence
-        int terminatorIdx = scanForTerminator(buffer, init_bufferPtr, sizeof(buffer));
-        if (terminatorIdx >= 0) {
-
-            // process data request here
-            char parsedBuffer[64] = { 0 };
-            memcpy(parsedBuffer, buffer, min(terminatorIdx, sizeof(parsedBuffer) - 1));
-            memcpy(buffer, buffer + terminatorIdx + 1, bufferPtr - terminatorIdx - 1);
-            bufferPtr -= terminatorIdx - 1;
-            Command_parse(&container, parsedBuffer, sizeof(parsedBuffer));
-        }
-        // if buffer is full, then clear buffer because this is an error
-        else if (bufferPtr >= sizeof(buffer)) {
+        fields |= 1 << field;
+    }
+
+    writeRecord(fields);
+}
+
+void logStatus(char **args, uint8_t argc)
+{
+    Serial.print(F("/log records "));
+    Serial.print(sampleLog.records());
+    Serial.print(F(" bytes "));
+    Serial.print(sampleLog.bytes());
+    Serial.print('/');
+    Serial.print(sampleLog.capacity());
+    Serial.print(F(" period "));
+    Serial.println(logPeriod);
+}
+
+void logDump(char **args, uint8_t argc)
+{
+    Serial.print(F("/log dump "));
+    Serial.println(sampleLog.startDump());
+    if (!sampleLog.dumping()) Serial.println(F("/log end"));
+}
+
+void logClear(char **args, uint8_t argc)
+{
+    sampleLog.clear();
+    Serial.println(F("/log clear"));
+}
+
+void logPeriodSet(char **args, uint8_t argc)
+{
+    logPeriod = strtoul(args[0], nullptr, 10);
+    Serial.print(F("/log period "));
+    Serial.println(logPeriod);
+}
+
+void statsMem(char **args, uint8_t argc)
+{
+    if (!StackMonitor::supported()) {
+        Serial.println(F("/stats mem unsupported"));
+        return;
+    }
+
+    Serial.print(F("/stats mem static "));
+    Serial.print(StackMonitor::staticSize());
+    Serial.print(F(" heap "));
+    Serial.print(StackMonitor::heapSize());
+    Serial.print(F(" stack_peak "));
+    Serial.print(StackMonitor::stackPeak());
+    Serial.print(F(" free "));
+    Serial.print(StackMonitor::freeNow());
+    Serial.print(F(" free_min "));
+    Serial.println(StackMonitor::freeMin());
+}
 
-            memset(buffer, 0, sizeof(buffer));
-            bufferPtr = 0;
-            Utils::print("/err: buffer-overflow -> You told me way too many things before I can process them :(");
+void statsProf(char **args, uint8_t argc)
+{
+#ifdef PROFILE
+    for (uint8_t i = 0; i < Profiler::PROBE_COUNT; ++i) {
+        const Profiler::Stats &stats = Profiler::stats(i);
+
+        Serial.print(F("/stats prof "));
+        Serial.print((const __FlashStringHelper *) Profiler::name(i));
+        Serial.print(F(" n "));
+        Serial.print(stats.count);
+        Serial.print(F(" avg "));
+        Serial.print(stats.count ? stats.total / stats.count : 0);
+        Serial.print(F(" max "));
+        Serial.print(stats.max);
+        Serial.print(F(" hist"));
+        for (uint8_t j = 0; j < Profiler::BUCKETS; ++j) {
+            Serial.print(' ');
+            Serial.print(stats.buckets[j]);
         }
+        Serial.println();
+    }
+    Serial.println(F("/stats prof end"));
+#else
+    Serial.println(F("/stats prof disabled, build with -D PROFILE"));
+#endif
+}
+
+void statsProfReset(char **args, uint8_t argc)
+{
+#ifdef PROFILE
+    Profiler::reset();
+#endif
+    Serial.println(F("/stats prof reset"));
+}
+
+void streamStart(char **args, uint8_t argc)
+{
+    unsigned long interval = argc ? strtoul(args[0], nullptr, 10) : 0;
+    Serial.print(F("/stream start "));
+    Serial.println(interval);
+    binaryStream.start(interval);
+}
+
+void streamStop(char **args, uint8_t argc)
+{
+    binaryStream.stop();
+    Serial.println(F("/stream stop"));
+}
+
+/**
+ * @brief Looks up a sample channel by its record field name, answers with an error if
+ *          there is none
+ * 
+ * @return uint8_t channel, CHANNEL_COUNT if unknown
+ */
+uint8_t alarmChannel(const char *name)
+{
+    uint8_t channel = 0;
+    while (channel < CHANNEL_COUNT
+           && strcmp_P(name, (const char *) pgm_read_ptr(&FIELD_NAMES[channel]))) {
+        ++channel;
+    }
+
+    if (channel == CHANNEL_COUNT) {
+        Serial.print(F("/err: Unknown channel "));
+        Serial.println(name);
+    }
+    return channel;
+}
+
+/**
+ * @brief Answers with the alarm configuration of a channel
+ */
+void writeAlarm(uint8_t channel)
+{
+    Serial.print(F("/alarm "));
+    Serial.print((const __FlashStringHelper *) pgm_read_ptr(&FIELD_NAMES[channel]));
+
+    if (!alarms.enabled(channel)) {
+        Serial.println(F(" off"));
+        return;
+    }
+
+    float low, high, hysteresis;
+    alarms.get(channel, low, high, hysteresis);
+    Serial.print(F(" limits "));
+    Format::decimal<2>(Serial, low);
+    Serial.print(' ');
+    Format::decimal<2>(Serial, high);
+    Serial.print(' ');
+    Format::decimal<2>(Serial, hysteresis);
+
+    switch (alarms.state(channel)) {
+    case Alarms<CHANNEL_COUNT>::BELOW: Serial.println(F(" low"));    break;
+    case Alarms<CHANNEL_COUNT>::ABOVE: Serial.println(F(" high"));   break;
+    default:                           Serial.println(F(" normal")); break;
+    }
+}
+
+void alarmGet(char **args, uint8_t argc)
+{
+    uint8_t channel = alarmChannel(args[0]);
+    if (channel < CHANNEL_COUNT) writeAlarm(channel);
+}
+
+void alarmSet(char **args, uint8_t argc)
+{
+    uint8_t channel = alarmChannel(args[0]);
+    if (channel == CHANNEL_COUNT) return;
+
+    if (!alarms.set(channel, atof(args[1]), atof(args[2]), atof(args[3]))) {
+        Serial.println(F("/err: Invalid alarm limits"));
+        return;
+    }
+    saveCalibration();
+    writeAlarm(channel);
+}
+
+void alarmOff(char **args, uint8_t argc)
+{
+    uint8_t channel = alarmChannel(args[0]);
+    if (channel == CHANNEL_COUNT) return;
+
+    alarms.disable(channel);
+    saveCalibration();
+    writeAlarm(channel);
+}
+
+//      id                 verb path               args      handler
+#define COMMAND_TABLE(X) \
+    X(FLUSH,             "flush",                "",       flushCommand)       \
+    X(ECHO,              "echo",                 "*",      echoCommand)        \
+    X(PH,                "ph",                   "",       phRead)             \
+    X(PH_CAL_START,      "ph calibrate start",   "",       phCalibrateStart)   \
+    X(PH_CAL_GET,        "ph calibrate get",     "",       phCalibrateGet)     \
+    X(PH_CAL_SET,        "ph calibrate set",     "nn",     phCalibrateSet)     \
+    X(PH_CAL_POINT,      "ph calibrate point",   "n",      phCalibratePoint)   \
+    X(PH_CAL_POINTS,     "ph calibrate points",  "",       phCalibratePoints)  \
+    X(PH_CAL_CLEAR,      "ph calibrate clear",   "",       phCalibrateClear)   \
+    X(EC,                "ec",                   "",       ecRead)             \
+    X(EC_CAL_START,      "ec calibrate start",   "",       ecCalibrateStart)   \
+    X(EC_CAL_GET,        "ec calibrate get",     "",       ecCalibrateGet)     \
+    X(EC_CAL_SET,        "ec calibrate set",     "nn",     ecCalibrateSet)     \
+    X(EC_CAL_POINT,      "ec calibrate point",   "n",      ecCalibratePoint)   \
+    X(EC_CAL_POINTS,     "ec calibrate points",  "",       ecCalibratePoints)  \
+    X(EC_CAL_CLEAR,      "ec calibrate clear",   "",       ecCalibrateClear)   \
+    X(TURB,              "turb",                 "",       turbRead)           \
+    X(TURB_CAL_GET,      "turb calibrate get",   "",       turbCalibrateGet)   \
+    X(TURB_CAL_SET,      "turb calibrate set",   "nn",     turbCalibrateSet)   \
+    X(TURB_CAL_POINT,    "turb calibrate point", "n",      turbCalibratePoint) \
+    X(TURB_CAL_POINTS,   "turb calibrate points", "",      turbCalibratePoints) \
+    X(TURB_CAL_CLEAR,    "turb calibrate clear", "",       turbCalibrateClear) \
+    X(TURB_HELP,         "turb help",            "",       turbHelp)           \
+    X(TDS,               "tds",                  "",       tdsRead)            \
+    X(TDS_CAL_GET,       "tds calibrate get",    "",       tdsCalibrateGet)    \
+    X(TDS_CAL_SET,       "tds calibrate set",    "nn",     tdsCalibrateSet)    \
+    X(TDS_MODE,          "tds mode",             "?s",     tdsMode)            \
+    X(TEMP,              "temp",                 "",       tempRead)           \
+    X(ALL,               "all",                  "",       allRead)            \
+    X(READ,              "read",                 "?sssss", batchRead)          \
+    X(LOG,               "log",                  "",       logStatus)          \
+    X(LOG_DUMP,          "log dump",             "",       logDump)            \
+    X(LOG_CLEAR,         "log clear",            "",       logClear)           \
+    X(LOG_PERIOD,        "log period",           "n",      logPeriodSet)       \
+    X(STATS_MEM,         "stats mem",            "",       statsMem)           \
+    X(STATS_PROF,        "stats prof",           "",       statsProf)          \
+    X(STATS_PROF_RESET,  "stats prof reset",     "",       statsProfReset)     \
+    X(STREAM_START,      "stream start",         "?n",     streamStart)        \
+    X(STREAM_STOP,       "stream stop",          "",       streamStop)         \
+    X(ALARM_GET,         "alarm get",            "s",      alarmGet)           \
+    X(ALARM_SET,         "alarm set",            "snnn",   alarmSet)           \
+    X(ALARM_OFF,         "alarm off",            "s",      alarmOff)
+
+DEFINE_COMMAND_TABLE(commands, COMMAND_TABLE)
+
+void setup()
+{
+    // put your setup code here, to run once:
+    Serial.begin(9600);
+    Serial.println("-> Initialized");
+
+#ifdef USE_WATER_TEMPERATURE
+    waterTemperature.init();
+    ec.setWaterTemperatureSensor(&waterTemperature);    
+    tds.setWaterTemperatureSensor(&waterTemperature);
+#endif
+
+#ifdef BOARD_DUE
+    // the Due core reads 10 bits by default, the board profile scales for the full ADC
+    analogReadResolution(Board::Current::ADC_BITS);
+#endif
+
+#ifdef USE_ADC_CAPTURE
+    AdcCapture::begin(CAPTURE_PINS, sizeof(CAPTURE_PINS));
+#endif
+
+    ph.init();
+    ec.init();
+    turb.init();
+    tds.init();
+    tds.setECSensor(&ec);
+    loadCalibration();
+
+    sampler.attach(CHANNEL_PH, &ph, PH_SAMPLE_PERIOD);
+    sampler.attach(CHANNEL_EC, &ec, EC_SAMPLE_PERIOD);
+    sampler.attach(CHANNEL_TURB, &turb, TURB_SAMPLE_PERIOD);
+    scheduleTds();
+    sampler.setListener(onSample);
+}
+
+void loop()
+{
+    PROFILE_SCOPE(LOOP);
+
+#ifdef USE_WATER_TEMPERATURE
+    waterTemperature.update();
+#endif
+    sampler.update(millis());
+    updateAlarms();
+    updateLog(millis());
+    updateLogDump();
+
+    {
+        PROFILE_SCOPE(LINE_POLL);
+        lineReader.poll(Serial, millis());
+    }
+
+    if (lineReader.overflowed()) {
+        Serial.print(F("/err: Too many characters received. Maximum command must be "));
+        Serial.print(lineReader.capacity());
+        Serial.print(F(" characters\r\n"));
+    }
+
+    char *line = lineReader.line();
+    if (!line) return;
+
+    Serial.print(F("-> The command received: \""));
+    Serial.print(line);
+    Serial.print(F("\"\n"));
+
+    Commands::Result result;
+    {
+        PROFILE_SCOPE(CMD_DISPATCH);
+        result = Commands::dispatch(commands, line);
     }
-  */   // put your main code here, to run repeatedly:
-}
\ No newline at end of file
+
+    switch (result) {
+    case Commands::OK:
+        break;
+    case Commands::BAD_ARGUMENTS:
+        Serial.println(F("/err: Invalid arguments"));
+        break;
+    default:
+        Serial.println(F("/err: Invalid command"));
+        break;
+    }
+
+    lineReader.release();
+}
@@ -4,48 +4,56 @@
 #include <Stream.h>
 // #include <ArduinoJson.h>
 #include <assert.h>
+#include "Board.h"
+#include "Format.h"
 
-#ifdef DUE
-    #define RESOLUTION_BITS                   12
-    #define VREF                            3.3f
-    #define VREF_MILLI          (VREF * 1000.0f)
-    #define ANALOG_RESOLUTION            4095.0f
-#elif UNO
-    #define RESOLUTION_BITS                   10
-    #define VREF                            5.0f
-    #define VREF_MILLI          (VREF * 1000.0f)
-    #define ANALOG_RESOLUTION            1023.0f
-#else
-    #define RESOLUTION_BITS                   10
-    #define VREF                            5.0f
-    #define VREF_MILLI          (VREF * 1000.0f)
-    #define ANALOG_RESOLUTION            1023.0f
+// PH and EC convert samples with Q16.16 fixed-point kernels (FixedPoint.h).
+// Define FLOAT_CONVERSION to use the float reference path instead
+#ifndef FLOAT_CONVERSION
+    #define USE_FIXED_POINT
 #endif
 
-#ifndef DUE
-    #pragma message "WARNING! This code is not tested on other boards besides the Arduino Due"
+// Analog inputs are captured by the free-running ADC interrupt (AdcCapture.h) on
+// boards that have one, see Board.h. Elsewhere, or with ADC_POLLING defined, the
+// blocking analogRead() is used instead
+#if BOARD_HAS_ADC_CAPTURE && !defined(ADC_POLLING)
+    #define USE_ADC_CAPTURE
 #endif
 
-#if (defined(DTOSTRF_EXT_LIB) || defined(DUE)) && !defined(ESP32)
-char *dtostrf (double val, signed char width, unsigned char prec, char *sout);
+// Calibration is kept in EEPROM (CalibrationStore.h) on boards that have one, see
+// Board.h. The Due has no EEPROM and starts with the default calibration
+#if BOARD_HAS_EEPROM && !defined(NO_CALIBRATION_STORE)
+    #define USE_CALIBRATION_STORE
+#endif
 
+// EC is temperature compensated with a DS18B20 on the 1-Wire bus (WaterTemperature.h).
+// Define NO_WATER_TEMPERATURE to compensate for a fixed 25 C instead
+#if BOARD_HAS_ONE_WIRE && !defined(NO_WATER_TEMPERATURE)
+    #define USE_WATER_TEMPERATURE
+#endif
+
+#ifndef DUE
+    #pragma message "WARNING! This code is not tested on other boards besides the Arduino Due"
 #endif
 
 // #define DEBUG
 #ifdef DEBUG
-    extern char *_devprintln;
     #pragma message "DEBUG mode is enabled!"
 
+    // dev_printf formats on the stack, longer messages are truncated
+    #define DEV_PRINTF_SIZE 64
+
     #define dev_print(x)
     // #define dev_println(x)
     // #define dev_printf(f, ...)
     
     // #define dev_print(x) Serial.print(x)
     #define dev_println(x) Serial.println(x)
-    #define dev_printf(f, ...) _devprintln = new char[256]; \
-                                 sprintf(_devprintln, f, ##__VA_ARGS__); \
-                                 Serial.print(_devprintln);  \
-                                 delete[] _devprintln
+    #define dev_printf(f, ...) do { \
+                                     char _devprintln[DEV_PRINTF_SIZE]; \
+                                     snprintf(_devprintln, DEV_PRINTF_SIZE, f, ##__VA_ARGS__); \
+                                     Serial.print(_devprintln); \
+                                 } while (0)
     // #define dev_delay(time) delay(time)
     #define dev_delay(time) 
 #else
@@ -106,9 +114,51 @@ namespace Utils {
 
     inline float voltageRead_milli(uint8_t pin)
     {
-        return analogRead(pin) / ANALOG_RESOLUTION * VREF * 1000.0f;
+        return analogRead(pin) * Board::millivoltsPerCount();
+    }
+
+    /**
+     * @brief CRC-8 with polynomial 0x07 (CRC-8/SMBUS), computed bit by bit to keep
+     *          flash usage low
+     * 
+     * @param data bytes to checksum
+     * @param size number of bytes
+     * @param crc initial value, pass the previous result to continue a checksum
+     * @return uint8_t checksum
+     */
+    inline uint8_t crc8(const uint8_t *data, size_t size, uint8_t crc = 0)
+    {
+        while (size--) {
+            crc ^= *data++;
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+            }
+        }
+        return crc;
     }
         
+    /**
+     * @brief Formats a record field `"name": value,` for SensorInterface::write()
+     * 
+     * @tparam DECIMALS digits after the decimal point
+     * @param buffer output, at least SensorInterface::FIELD_SIZE bytes
+     * @param size size of buffer
+     * @param name field name
+     * @param value field value
+     * @return size_t length of the field
+     */
+    template<uint8_t DECIMALS = 4>
+    size_t writeField(char *buffer, size_t size, const char *name, float value)
+    {
+        Format::BufferPrint out(buffer, size);
+        out.write('"');
+        out.write(name);
+        out.write("\": ");
+        Format::decimal<DECIMALS>(out, value);
+        out.write(',');
+        return out.written();
+    }
+
     /**
      * @deprecated
      * This does not even work
@@ -162,6 +212,9 @@ namespace Utils {
         // this is intentional, this will segfault the Arduino, thus this is an intentional self-kill
         void (*f)() = nullptr;
         f();
+#elif defined(NATIVE)
+        // the simulated board has nothing to reset, end the run instead
+        exit(EXIT_FAILURE);
 #else
 #error "Define a reset functionality for an equivalent board. A hardware reset is preffered"
 #endif
@@ -0,0 +1,133 @@
+#include <unity.h>
+#include <math.h>
+
+#include "Alarms.h"
+
+namespace {
+
+    typedef Alarms<2> ChannelAlarms;
+
+    void expectEvent(ChannelAlarms &alarms, uint8_t id, ChannelAlarms::State state, float value)
+    {
+        ChannelAlarms::State taken;
+        float sample;
+        TEST_ASSERT_TRUE(alarms.take(id, taken, sample));
+        TEST_ASSERT_EQUAL_UINT8(state, taken);
+        TEST_ASSERT_EQUAL_FLOAT(value, sample);
+        TEST_ASSERT_FALSE(alarms.pending(id));
+    }
+}
+
+void setUp() { }
+
+void tearDown() { }
+
+void test_rejects_invalid_limits()
+{
+    ChannelAlarms alarms;
+
+    TEST_ASSERT_FALSE(alarms.set(2, 6.5f, 8.5f, 0.1f));
+    TEST_ASSERT_FALSE(alarms.set(0, 8.5f, 6.5f, 0.1f));
+    TEST_ASSERT_FALSE(alarms.set(0, 6.5f, 8.5f, -0.1f));
+    TEST_ASSERT_FALSE(alarms.set(0, 6.5f, 8.5f, 2.5f));
+    TEST_ASSERT_FALSE(alarms.enabled(0));
+
+    TEST_ASSERT_TRUE(alarms.set(0, 6.5f, 8.5f, 2.0f));
+    TEST_ASSERT_TRUE(alarms.enabled(0));
+}
+
+void test_disabled_channel_never_triggers()
+{
+    ChannelAlarms alarms;
+
+    TEST_ASSERT_FALSE(alarms.update(0, -100.0f));
+    TEST_ASSERT_FALSE(alarms.pending(0));
+    TEST_ASSERT_EQUAL_UINT8(ChannelAlarms::NORMAL, alarms.state(0));
+}
+
+void test_hysteresis_holds_the_alarm()
+{
+    ChannelAlarms alarms;
+    alarms.set(0, 6.5f, 8.5f, 0.25f);
+
+    TEST_ASSERT_FALSE(alarms.update(0, 7.0f));
+
+    TEST_ASSERT_TRUE(alarms.update(0, 6.4f));
+    expectEvent(alarms, 0, ChannelAlarms::BELOW, 6.4f);
+
+    // back over the limit, but not by the hysteresis
+    TEST_ASSERT_FALSE(alarms.update(0, 6.6f));
+    TEST_ASSERT_EQUAL_UINT8(ChannelAlarms::BELOW, alarms.state(0));
+
+    TEST_ASSERT_TRUE(alarms.update(0, 6.75f));
+    expectEvent(alarms, 0, ChannelAlarms::NORMAL, 6.75f);
+
+    TEST_ASSERT_TRUE(alarms.update(0, 9.0f));
+    TEST_ASSERT_FALSE(alarms.update(0, 8.4f));
+    TEST_ASSERT_TRUE(alarms.update(0, 8.2f));
+    expectEvent(alarms, 0, ChannelAlarms::NORMAL, 8.2f);
+}
+
+void test_jumps_from_below_to_above()
+{
+    ChannelAlarms alarms;
+    alarms.set(1, 0.0f, 10.0f, 1.0f);
+
+    TEST_ASSERT_TRUE(alarms.update(1, -1.0f));
+    TEST_ASSERT_TRUE(alarms.update(1, 11.0f));
+
+    // the event was not taken, the newer one replaces it
+    expectEvent(alarms, 1, ChannelAlarms::ABOVE, 11.0f);
+    TEST_ASSERT_FALSE(alarms.pending(0));
+}
+
+void test_nan_limit_never_triggers()
+{
+    ChannelAlarms alarms;
+    TEST_ASSERT_TRUE(alarms.set(0, NAN, 8.5f, 0.0f));
+
+    TEST_ASSERT_FALSE(alarms.update(0, -1000.0f));
+    TEST_ASSERT_TRUE(alarms.update(0, 9.0f));
+    expectEvent(alarms, 0, ChannelAlarms::ABOVE, 9.0f);
+}
+
+void test_disable_drops_the_pending_event()
+{
+    ChannelAlarms alarms;
+    alarms.set(0, 6.5f, 8.5f, 0.25f);
+    alarms.update(0, 9.0f);
+
+    alarms.disable(0);
+
+    ChannelAlarms::State state;
+    float value;
+    TEST_ASSERT_FALSE(alarms.pending(0));
+    TEST_ASSERT_FALSE(alarms.take(0, state, value));
+    TEST_ASSERT_FALSE(alarms.enabled(0));
+}
+
+void test_set_restarts_in_normal()
+{
+    ChannelAlarms alarms;
+    alarms.set(0, 6.5f, 8.5f, 0.25f);
+    alarms.update(0, 9.0f);
+
+    alarms.set(0, 6.5f, 9.5f, 0.25f);
+
+    TEST_ASSERT_EQUAL_UINT8(ChannelAlarms::NORMAL, alarms.state(0));
+    TEST_ASSERT_FALSE(alarms.pending(0));
+    TEST_ASSERT_FALSE(alarms.update(0, 9.0f));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_invalid_limits);
+    RUN_TEST(test_disabled_channel_never_triggers);
+    RUN_TEST(test_hysteresis_holds_the_alarm);
+    RUN_TEST(test_jumps_from_below_to_above);
+    RUN_TEST(test_nan_limit_never_triggers);
+    RUN_TEST(test_disable_drops_the_pending_event);
+    RUN_TEST(test_set_restarts_in_normal);
+    return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <unity.h>
+#include <string.h>
+#include <EEPROM.h>
+
+#include "CalibrationStore.h"
+
+namespace {
+
+    const size_t RECORD_SIZE = CalibrationStore::size() / CalibrationStore::SLOTS;
+
+    CalibrationData calibration(float phNeutral)
+    {
+        CalibrationData data;
+        memset(&data, 0, sizeof(data));
+        data.phNeutral = phNeutral;
+        data.tdsFactor = 0.5f;
+        return data;
+    }
+
+    float loadPhNeutral()
+    {
+        CalibrationStore store;
+        CalibrationData data = calibration(-1.0f);
+        TEST_ASSERT_TRUE(store.load(data));
+        return data.phNeutral;
+    }
+
+    bool slotWritten(uint8_t slot)
+    {
+        return EEPROM.read(slot * RECORD_SIZE) == CalibrationStore::VERSION;
+    }
+}
+
+void setUp()
+{
+    for (uint16_t i = 0; i < EEPROM.length(); ++i) EEPROM.write(i, 0xFF);
+}
+
+void tearDown() { }
+
+void test_erased_eeprom_has_no_record()
+{
+    CalibrationStore store;
+    CalibrationData data = calibration(1.0f);
+
+    TEST_ASSERT_FALSE(store.load(data));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, data.phNeutral);
+}
+
+void test_fits_at_least_two_slots()
+{
+    TEST_ASSERT_TRUE(CalibrationStore::SLOTS >= 2);
+    TEST_ASSERT_TRUE(CalibrationStore::size() <= EEPROM.length());
+}
+
+void test_saves_rotate_through_the_slots()
+{
+    CalibrationStore store;
+    CalibrationData data;
+    store.load(data);
+
+    TEST_ASSERT_TRUE(store.save(calibration(1.0f)));
+    TEST_ASSERT_TRUE(slotWritten(0));
+    TEST_ASSERT_FALSE(slotWritten(1));
+
+    for (uint8_t i = 1; i < CalibrationStore::SLOTS; ++i) {
+        TEST_ASSERT_TRUE(store.save(calibration(1.0f + i)));
+        TEST_ASSERT_TRUE(slotWritten(i));
+    }
+
+    // the next save overwrites the oldest record in slot 0
+    TEST_ASSERT_TRUE(store.save(calibration(100.0f)));
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, loadPhNeutral());
+}
+
+void test_newest_record_wins_after_reset()
+{
+    CalibrationStore store;
+    CalibrationData data;
+    store.load(data);
+
+    for (uint8_t i = 0; i < 3 * CalibrationStore::SLOTS + 1; ++i) store.save(calibration(i));
+
+    TEST_ASSERT_EQUAL_FLOAT(3 * CalibrationStore::SLOTS, loadPhNeutral());
+}
+
+void test_corrupted_record_falls_back_to_the_previous()
+{
+    CalibrationStore store;
+    CalibrationData data;
+    store.load(data);
+
+    store.save(calibration(1.0f));
+    store.save(calibration(2.0f));
+
+    // a write interrupted in the middle of slot 1
+    uint16_t address = RECORD_SIZE + RECORD_SIZE / 2;
+    EEPROM.write(address, EEPROM.read(address) ^ 0x01);
+
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, loadPhNeutral());
+}
+
+void test_identical_save_writes_nothing()
+{
+    CalibrationStore store;
+    CalibrationData data;
+    store.load(data);
+
+    store.save(calibration(1.0f));
+    uint32_t writes = EEPROM.writes();
+
+    TEST_ASSERT_TRUE(store.save(calibration(1.0f)));
+    TEST_ASSERT_EQUAL_UINT32(writes, EEPROM.writes());
+    TEST_ASSERT_FALSE(slotWritten(1));
+}
+
+void test_sequence_wraps_around()
+{
+    CalibrationStore store;
+    CalibrationData data;
+    store.load(data);
+
+    // the 16 bit sequence number wraps after 65535 saves, the newest record still wins
+    for (uint32_t i = 0; i < 70000; ++i) TEST_ASSERT_TRUE(store.save(calibration(i % 2 ? 1.0f : 2.0f)));
+    store.save(calibration(3.0f));
+
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, loadPhNeutral());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_erased_eeprom_has_no_record);
+    RUN_TEST(test_fits_at_least_two_slots);
+    RUN_TEST(test_saves_rotate_through_the_slots);
+    RUN_TEST(test_newest_record_wins_after_reset);
+    RUN_TEST(test_corrupted_record_falls_back_to_the_previous);
+    RUN_TEST(test_identical_save_writes_nothing);
+    RUN_TEST(test_sequence_wraps_around);
+    return UNITY_END();
+}
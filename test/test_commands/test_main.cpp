@@ -0,0 +1,160 @@
+#include <unity.h>
+#include <string.h>
+
+#include "Commands.h"
+
+namespace {
+
+    // handler that was called last and its arguments
+    const char *called = nullptr;
+    uint8_t calledArgc = 0;
+    char calledArgs[Commands::MAX_TOKENS][64];
+
+    void record(const char *name, char **args, uint8_t argc)
+    {
+        called = name;
+        calledArgc = argc;
+        for (uint8_t i = 0; i < argc; ++i) {
+            strncpy(calledArgs[i], args[i], sizeof(calledArgs[i]) - 1);
+            calledArgs[i][sizeof(calledArgs[i]) - 1] = '\0';
+        }
+    }
+
+    void phRead(char **args, uint8_t argc) { record("ph", args, argc); }
+    void phCalibrateGet(char **args, uint8_t argc) { record("ph calibrate get", args, argc); }
+    void phCalibrateSet(char **args, uint8_t argc) { record("ph calibrate set", args, argc); }
+    void streamStart(char **args, uint8_t argc) { record("stream", args, argc); }
+    void tdsMode(char **args, uint8_t argc) { record("tds mode", args, argc); }
+    void note(char **args, uint8_t argc) { record("note", args, argc); }
+
+    #define TEST_COMMANDS(X)                                                  \
+        X(PH,           "ph",               "",     phRead)                   \
+        X(PH_CAL_GET,   "ph calibrate get", "",     phCalibrateGet)           \
+        X(PH_CAL_SET,   "ph calibrate set", "nn",   phCalibrateSet)           \
+        X(STREAM,       "stream",           "?nn",  streamStart)              \
+        X(TDS_MODE,     "tds mode",         "s",    tdsMode)                  \
+        X(NOTE,         "note",             "n*",   note)
+
+    DEFINE_COMMAND_TABLE(commands, TEST_COMMANDS)
+
+    Commands::Result dispatch(const char *line)
+    {
+        static char buffer[128];
+        strncpy(buffer, line, sizeof(buffer) - 1);
+        buffer[sizeof(buffer) - 1] = '\0';
+        return Commands::dispatch(commands, buffer);
+    }
+}
+
+void setUp()
+{
+    called = nullptr;
+    calledArgc = 0;
+}
+
+void tearDown() { }
+
+void test_empty_line()
+{
+    TEST_ASSERT_EQUAL_UINT8(Commands::EMPTY, dispatch(""));
+    TEST_ASSERT_EQUAL_UINT8(Commands::EMPTY, dispatch("  \r\n"));
+    TEST_ASSERT_NULL(called);
+}
+
+void test_unknown_command()
+{
+    TEST_ASSERT_EQUAL_UINT8(Commands::UNKNOWN, dispatch("orp"));
+    TEST_ASSERT_EQUAL_UINT8(Commands::UNKNOWN, dispatch("calibrate ph"));
+    TEST_ASSERT_EQUAL_UINT8(Commands::UNKNOWN, dispatch("phcalibrate"));
+    TEST_ASSERT_NULL(called);
+}
+
+void test_longest_path_wins()
+{
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("ph"));
+    TEST_ASSERT_EQUAL_STRING("ph", called);
+
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("ph calibrate get"));
+    TEST_ASSERT_EQUAL_STRING("ph calibrate get", called);
+    TEST_ASSERT_EQUAL_UINT8(0, calledArgc);
+
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("  ph   calibrate set 2.5 7\r\n"));
+    TEST_ASSERT_EQUAL_STRING("ph calibrate set", called);
+    TEST_ASSERT_EQUAL_UINT8(2, calledArgc);
+    TEST_ASSERT_EQUAL_STRING("2.5", calledArgs[0]);
+    TEST_ASSERT_EQUAL_STRING("7", calledArgs[1]);
+}
+
+void test_shorter_path_gets_the_other_words_as_arguments()
+{
+    // "ph" takes no arguments, so "ph calibrate" is not a command
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("ph calibrate"));
+    TEST_ASSERT_NULL(called);
+}
+
+void test_numbers_are_validated()
+{
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("ph calibrate set 2.5"));
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("ph calibrate set 2.5 7 4"));
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("ph calibrate set 2.5 seven"));
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("ph calibrate set 2.5x 7"));
+    TEST_ASSERT_NULL(called);
+
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("ph calibrate set -1e3 .5"));
+}
+
+void test_optional_arguments()
+{
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("stream"));
+    TEST_ASSERT_EQUAL_UINT8(0, calledArgc);
+
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("stream 3"));
+    TEST_ASSERT_EQUAL_UINT8(1, calledArgc);
+
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("stream 3 100"));
+    TEST_ASSERT_EQUAL_UINT8(2, calledArgc);
+
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("stream 3 100 5"));
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("stream fast"));
+}
+
+void test_word_arguments()
+{
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("tds mode cubic"));
+    TEST_ASSERT_EQUAL_STRING("cubic", calledArgs[0]);
+
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("tds mode"));
+    TEST_ASSERT_EQUAL_UINT8(Commands::BAD_ARGUMENTS, dispatch("tds mode cubic linear"));
+}
+
+void test_rest_of_line_is_joined()
+{
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("note 3 tank two  refilled"));
+    TEST_ASSERT_EQUAL_UINT8(2, calledArgc);
+    TEST_ASSERT_EQUAL_STRING("3", calledArgs[0]);
+    TEST_ASSERT_EQUAL_STRING("tank two  refilled", calledArgs[1]);
+
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("note 3"));
+    TEST_ASSERT_EQUAL_UINT8(1, calledArgc);
+}
+
+void test_rest_of_line_keeps_words_past_the_token_limit()
+{
+    TEST_ASSERT_EQUAL_UINT8(Commands::OK, dispatch("note 1 a b c d e f g h i j k"));
+    TEST_ASSERT_EQUAL_STRING("a b c d e f g h i j k", calledArgs[1]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_line);
+    RUN_TEST(test_unknown_command);
+    RUN_TEST(test_longest_path_wins);
+    RUN_TEST(test_shorter_path_gets_the_other_words_as_arguments);
+    RUN_TEST(test_numbers_are_validated);
+    RUN_TEST(test_optional_arguments);
+    RUN_TEST(test_word_arguments);
+    RUN_TEST(test_rest_of_line_is_joined);
+    RUN_TEST(test_rest_of_line_keeps_words_past_the_token_limit);
+    return UNITY_END();
+}
@@ -0,0 +1,95 @@
+#include <unity.h>
+
+#include "Filters.h"
+
+void setUp() { }
+
+void tearDown() { }
+
+void test_median_rejects_single_spikes()
+{
+    Filters::Median<5> median;
+
+    TEST_ASSERT_EQUAL_INT32(500, median.push(500));
+    TEST_ASSERT_EQUAL_INT32(502, median.push(502));
+    TEST_ASSERT_EQUAL_INT32(502, median.push(1023));
+    TEST_ASSERT_EQUAL_INT32(502, median.push(501));
+    TEST_ASSERT_EQUAL_INT32(501, median.push(0));
+    TEST_ASSERT_EQUAL_INT32(501, median.push(499));
+}
+
+void test_boxcar_averages_the_last_samples()
+{
+    Filters::Boxcar<4> boxcar;
+
+    TEST_ASSERT_EQUAL_INT32(100, boxcar.push(100));
+    TEST_ASSERT_EQUAL_INT32(150, boxcar.push(200));
+    TEST_ASSERT_EQUAL_INT32(200, boxcar.push(300));
+    TEST_ASSERT_EQUAL_INT32(250, boxcar.push(400));
+
+    // the 100 leaves the window
+    TEST_ASSERT_EQUAL_INT32(350, boxcar.push(500));
+}
+
+void test_ema_starts_at_the_first_sample()
+{
+    Filters::Ema<2> ema;
+
+    TEST_ASSERT_EQUAL_INT32(400, ema.push(400));
+    TEST_ASSERT_EQUAL_INT32(500, ema.push(800));
+    TEST_ASSERT_EQUAL_INT32(575, ema.push(800));
+}
+
+void test_ema_keeps_small_steps()
+{
+    Filters::Ema<3> ema;
+
+    ema.push(100);
+
+    int32_t value = 0;
+    for (uint8_t i = 0; i < 100; ++i) value = ema.push(101);
+    TEST_ASSERT_EQUAL_INT32(101, value);
+}
+
+void test_chain_runs_the_stages_in_order()
+{
+    // the median removes the spike before it reaches the average
+    Filters::Chain<Filters::Median<3>, Filters::Boxcar<2> > chain;
+
+    chain.push(100);
+    chain.push(100);
+    TEST_ASSERT_EQUAL_INT32(100, chain.push(1000));
+    TEST_ASSERT_EQUAL_INT32(100, chain.push(100));
+}
+
+void test_empty_chain_passes_samples_through()
+{
+    Filters::None none;
+
+    TEST_ASSERT_EQUAL_INT32(-7, none.push(-7));
+    TEST_ASSERT_EQUAL_INT32(1023, none.push(1023));
+}
+
+void test_reset_forgets_every_stage()
+{
+    Filters::Chain<Filters::Boxcar<4>, Filters::Ema<2> > chain;
+
+    chain.push(1000);
+    chain.push(1000);
+    chain.reset();
+
+    TEST_ASSERT_EQUAL_INT32(10, chain.push(10));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_median_rejects_single_spikes);
+    RUN_TEST(test_boxcar_averages_the_last_samples);
+    RUN_TEST(test_ema_starts_at_the_first_sample);
+    RUN_TEST(test_ema_keeps_small_steps);
+    RUN_TEST(test_chain_runs_the_stages_in_order);
+    RUN_TEST(test_empty_chain_passes_samples_through);
+    RUN_TEST(test_reset_forgets_every_stage);
+    return UNITY_END();
+}
@@ -0,0 +1,60 @@
+#include <unity.h>
+#include <math.h>
+
+#include "FixedPoint.h"
+
+void setUp() { }
+
+void tearDown() { }
+
+void test_float_round_trip()
+{
+    TEST_ASSERT_EQUAL_INT32(Fixed::ONE, Fixed::fromFloat(1.0f));
+    TEST_ASSERT_EQUAL_INT32(-Fixed::ONE / 2, Fixed::fromFloat(-0.5f));
+    TEST_ASSERT_EQUAL_FLOAT(-7.25f, Fixed::toFloat(Fixed::fromFloat(-7.25f)));
+}
+
+void test_linear_matches_float()
+{
+    Fixed::Linear linear;
+    TEST_ASSERT_TRUE(linear.set(0.0146f, 2.5f, 1023));
+
+    for (int32_t x = 0; x <= 1023; ++x) {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0146f * x + 2.5f, Fixed::toFloat(linear.apply(x)));
+    }
+}
+
+void test_linear_negative_gain()
+{
+    // the pH probe voltage falls as the pH rises
+    Fixed::Linear linear;
+    TEST_ASSERT_TRUE(linear.set(-0.0178f, 21.34f, 1023));
+
+    for (int32_t x = 0; x <= 1023; ++x) {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, -0.0178f * x + 21.34f, Fixed::toFloat(linear.apply(x)));
+    }
+}
+
+void test_linear_rejects_invalid_coefficients()
+{
+    Fixed::Linear linear;
+    TEST_ASSERT_TRUE(linear.set(1.0f, 1.0f, 1023));
+
+    TEST_ASSERT_FALSE(linear.set(NAN, 0.0f, 1023));
+    TEST_ASSERT_FALSE(linear.set(INFINITY, 0.0f, 1023));
+    TEST_ASSERT_FALSE(linear.set(1.0f, NAN, 1023));
+    TEST_ASSERT_FALSE(linear.set(1.0f, 40000.0f, 1023));
+
+    // the coefficients of the last valid set() are kept
+    TEST_ASSERT_EQUAL_FLOAT(11.0f, Fixed::toFloat(linear.apply(10)));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_float_round_trip);
+    RUN_TEST(test_linear_matches_float);
+    RUN_TEST(test_linear_negative_gain);
+    RUN_TEST(test_linear_rejects_invalid_coefficients);
+    return UNITY_END();
+}
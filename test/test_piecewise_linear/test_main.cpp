@@ -0,0 +1,140 @@
+#include <unity.h>
+
+#include "PiecewiseLinear.h"
+
+namespace {
+
+    typedef PiecewiseLinear<4> Calibration;
+
+    const int32_t MAX_INPUT = 1023;
+
+    /**
+     * @brief 0 counts are 0, 100 are 10, 300 are 30 and 700 are 10, so every segment
+     *          has a different slope
+     */
+    void fill(Calibration &calibration)
+    {
+        calibration.add(300, 30.0f);
+        calibration.add(0, 0.0f);
+        calibration.add(700, 10.0f);
+        calibration.add(100, 10.0f);
+    }
+}
+
+void setUp() { }
+
+void tearDown() { }
+
+void test_points_are_kept_sorted()
+{
+    Calibration calibration(MAX_INPUT);
+    fill(calibration);
+
+    TEST_ASSERT_EQUAL_UINT8(4, calibration.size());
+    TEST_ASSERT_EQUAL_UINT16(0, calibration[0].counts);
+    TEST_ASSERT_EQUAL_UINT16(100, calibration[1].counts);
+    TEST_ASSERT_EQUAL_UINT16(300, calibration[2].counts);
+    TEST_ASSERT_EQUAL_UINT16(700, calibration[3].counts);
+}
+
+void test_same_counts_replace_the_point()
+{
+    Calibration calibration(MAX_INPUT);
+    fill(calibration);
+
+    TEST_ASSERT_TRUE(calibration.add(300, 40.0f));
+    TEST_ASSERT_EQUAL_UINT8(4, calibration.size());
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, calibration[2].value);
+}
+
+void test_full_table_rejects_new_points()
+{
+    Calibration calibration(MAX_INPUT);
+    fill(calibration);
+
+    TEST_ASSERT_FALSE(calibration.add(500, 20.0f));
+    TEST_ASSERT_EQUAL_UINT8(4, calibration.size());
+}
+
+void test_needs_two_points()
+{
+    Calibration calibration(MAX_INPUT);
+    TEST_ASSERT_FALSE(calibration.active());
+
+    calibration.add(100, 1.0f);
+    TEST_ASSERT_FALSE(calibration.active());
+
+    calibration.add(200, 2.0f);
+    TEST_ASSERT_TRUE(calibration.active());
+}
+
+void test_interpolates_inside_each_segment()
+{
+    Calibration calibration(MAX_INPUT);
+    fill(calibration);
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, calibration.apply(0));
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, calibration.apply(50));
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, calibration.apply(100));
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, calibration.apply(200));
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, calibration.apply(300));
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, calibration.apply(500));
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, calibration.apply(700));
+}
+
+void test_extrapolates_along_the_last_segment()
+{
+    Calibration calibration(MAX_INPUT);
+    calibration.add(100, 10.0f);
+    calibration.add(200, 20.0f);
+    calibration.add(300, 40.0f);
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, calibration.apply(0));
+    TEST_ASSERT_EQUAL_FLOAT(80.0f, calibration.apply(500));
+}
+
+void test_fixed_point_matches_float()
+{
+    Calibration calibration(MAX_INPUT);
+    fill(calibration);
+    calibration.setScale(0.9f);
+
+    for (uint16_t counts = 0; counts <= MAX_INPUT; ++counts) {
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, calibration.apply(counts), Fixed::toFloat(calibration.applyFixed(counts)));
+    }
+}
+
+void test_load_rejects_unsorted_tables()
+{
+    Calibration calibration(MAX_INPUT);
+
+    Calibration::Table table;
+    table.count = 3;
+    table.points[0] = { 100, 1.0f };
+    table.points[1] = { 100, 2.0f };
+    table.points[2] = { 300, 3.0f };
+
+    TEST_ASSERT_FALSE(calibration.load(table));
+    TEST_ASSERT_EQUAL_UINT8(0, calibration.size());
+
+    table.points[1].counts = 200;
+    TEST_ASSERT_TRUE(calibration.load(table));
+    TEST_ASSERT_EQUAL_FLOAT(2.5f, calibration.apply(250));
+
+    table.count = 5;
+    TEST_ASSERT_FALSE(calibration.load(table));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_points_are_kept_sorted);
+    RUN_TEST(test_same_counts_replace_the_point);
+    RUN_TEST(test_full_table_rejects_new_points);
+    RUN_TEST(test_needs_two_points);
+    RUN_TEST(test_interpolates_inside_each_segment);
+    RUN_TEST(test_extrapolates_along_the_last_segment);
+    RUN_TEST(test_fixed_point_matches_float);
+    RUN_TEST(test_load_rejects_unsorted_tables);
+    return UNITY_END();
+}
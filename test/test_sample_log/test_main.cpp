@@ -0,0 +1,177 @@
+#include <unity.h>
+
+#include "SampleLog.h"
+
+namespace {
+
+    typedef SampleLog<64, 2> Log;
+
+    void append(Log &log, unsigned long time, float a, float b)
+    {
+        float values[2] = { a, b };
+        log.append(time, values);
+    }
+
+    /**
+     * @brief dumps the whole log and checks it against the expected records
+     */
+    void expectDump(Log &log, const unsigned long *times, const float (*values)[2], uint16_t count)
+    {
+        TEST_ASSERT_EQUAL_UINT16(count, log.startDump());
+
+        unsigned long time;
+        float decoded[2];
+        for (uint16_t i = 0; i < count; ++i) {
+            TEST_ASSERT_TRUE(log.next(time, decoded));
+            TEST_ASSERT_EQUAL_UINT32(times[i], time);
+            TEST_ASSERT_EQUAL_FLOAT(values[i][0], decoded[0]);
+            TEST_ASSERT_EQUAL_FLOAT(values[i][1], decoded[1]);
+        }
+
+        TEST_ASSERT_FALSE(log.next(time, decoded));
+        TEST_ASSERT_FALSE(log.dumping());
+    }
+}
+
+void setUp() { }
+
+void tearDown() { }
+
+void test_small_differences_take_one_byte()
+{
+    Log log;
+
+    // 100 ms, +0.63 and -0.64 encode as zigzag(63) = 126 and zigzag(-64) = 127
+    append(log, 100, 0.63f, -0.64f);
+    TEST_ASSERT_EQUAL_UINT16(3, log.bytes());
+
+    // 128 ms and +0.64 need a second byte each
+    append(log, 228, 1.27f, -0.64f);
+    TEST_ASSERT_EQUAL_UINT16(3 + 5, log.bytes());
+}
+
+void test_large_differences_round_trip()
+{
+    Log log;
+
+    const unsigned long times[] = { 0, 70000, 4000000000UL };
+    const float values[][2] = {
+        { -1000.0f, 7.25f },
+        { 1000.0f, -7.25f },
+        { 0.01f, 0.0f },
+    };
+
+    for (uint8_t i = 0; i < 3; ++i) append(log, times[i], values[i][0], values[i][1]);
+    TEST_ASSERT_EQUAL_UINT16(3, log.records());
+
+    expectDump(log, times, values, 3);
+}
+
+void test_values_are_quantized_and_clamped()
+{
+    Log log;
+
+    append(log, 0, 1.234f, NAN);
+    append(log, 1, 1e12f, -1e12f);
+
+    const unsigned long times[] = { 0, 1 };
+    const float limit = Log::LIMIT / float(Log::SCALE);
+    const float values[][2] = {
+        { 1.23f, 0.0f },
+        { limit, -limit },
+    };
+    expectDump(log, times, values, 2);
+}
+
+void test_full_log_drops_oldest_records()
+{
+    Log log;
+
+    // every record takes 3 bytes, 21 of them fit into 64 bytes
+    for (unsigned long i = 0; i < 30; ++i) append(log, i * 10, i * 0.5f, -(i * 0.25f));
+
+    TEST_ASSERT_EQUAL_UINT16(21, log.records());
+    TEST_ASSERT_TRUE(log.bytes() <= Log::capacity());
+
+    unsigned long times[21];
+    float values[21][2];
+    for (uint8_t i = 0; i < 21; ++i) {
+        times[i] = (i + 9) * 10;
+        values[i][0] = (i + 9) * 0.5f;
+        values[i][1] = -((i + 9) * 0.25f);
+    }
+    expectDump(log, times, values, 21);
+}
+
+void test_dump_includes_records_appended_during_dump()
+{
+    Log log;
+
+    append(log, 10, 1.0f, 2.0f);
+    append(log, 20, 3.0f, 4.0f);
+
+    unsigned long time;
+    float values[2];
+    TEST_ASSERT_EQUAL_UINT16(2, log.startDump());
+    TEST_ASSERT_TRUE(log.next(time, values));
+    TEST_ASSERT_EQUAL_UINT32(10, time);
+
+    append(log, 30, 5.0f, 6.0f);
+
+    TEST_ASSERT_TRUE(log.next(time, values));
+    TEST_ASSERT_EQUAL_UINT32(20, time);
+    TEST_ASSERT_TRUE(log.next(time, values));
+    TEST_ASSERT_EQUAL_UINT32(30, time);
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(6.0f, values[1]);
+    TEST_ASSERT_FALSE(log.next(time, values));
+}
+
+void test_dump_cursor_follows_dropped_records()
+{
+    Log log;
+
+    for (unsigned long i = 0; i < 21; ++i) append(log, i, i * 0.25f, 0.0f);
+
+    unsigned long time;
+    float values[2];
+    TEST_ASSERT_EQUAL_UINT16(21, log.startDump());
+    TEST_ASSERT_TRUE(log.next(time, values));
+    TEST_ASSERT_EQUAL_UINT32(0, time);
+
+    // drops records 0 to 2, record 1 and 2 were not sent yet and are skipped
+    for (unsigned long i = 21; i < 24; ++i) append(log, i, i * 0.25f, 0.0f);
+
+    for (unsigned long expected = 3; expected < 24; ++expected) {
+        TEST_ASSERT_TRUE(log.next(time, values));
+        TEST_ASSERT_EQUAL_UINT32(expected, time);
+        TEST_ASSERT_EQUAL_FLOAT(expected * 0.25f, values[0]);
+    }
+    TEST_ASSERT_FALSE(log.next(time, values));
+}
+
+void test_clear_empties_the_log()
+{
+    Log log;
+
+    append(log, 10, 1.0f, 2.0f);
+    log.clear();
+
+    TEST_ASSERT_EQUAL_UINT16(0, log.records());
+    TEST_ASSERT_EQUAL_UINT16(0, log.bytes());
+    TEST_ASSERT_EQUAL_UINT16(0, log.startDump());
+    TEST_ASSERT_FALSE(log.dumping());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_small_differences_take_one_byte);
+    RUN_TEST(test_large_differences_round_trip);
+    RUN_TEST(test_values_are_quantized_and_clamped);
+    RUN_TEST(test_full_log_drops_oldest_records);
+    RUN_TEST(test_dump_includes_records_appended_during_dump);
+    RUN_TEST(test_dump_cursor_follows_dropped_records);
+    RUN_TEST(test_clear_empties_the_log);
+    return UNITY_END();
+}
@@ -0,0 +1,216 @@
+#include <unity.h>
+#include <string.h>
+
+#include <TesterProtocol.h>
+
+using Tester::Text;
+
+namespace {
+
+    void expectText(const char *expected, const Text &text)
+    {
+        TEST_ASSERT_EQUAL_UINT32(strlen(expected), text.size);
+        TEST_ASSERT_EQUAL_MEMORY(expected, text.data, text.size);
+    }
+
+    /**
+     * @brief sample packet as src/BinaryStream.h sends it
+     */
+    void packet(uint8_t *out, uint8_t channel, uint8_t sequence, int32_t raw)
+    {
+        out[0] = Tester::PACKET_SYNC;
+        out[1] = channel;
+        out[2] = sequence;
+        for (uint8_t i = 0; i < 4; ++i) out[3 + i] = static_cast<uint32_t>(raw) >> (8 * i);
+        out[7] = Tester::crc8(out, 7);
+    }
+}
+
+void setUp() { }
+
+void tearDown() { }
+
+void test_text_words()
+{
+    Text line("/ph calibration end");
+
+    expectText("/ph", line.word(0));
+    expectText("end", line.word(2));
+    TEST_ASSERT_TRUE(line.word(3).empty());
+    expectText("calibration end", line.after(1));
+}
+
+void test_text_numbers()
+{
+    float value;
+    TEST_ASSERT_TRUE(Text("7.25").toFloat(value));
+    TEST_ASSERT_EQUAL_FLOAT(7.25f, value);
+    TEST_ASSERT_TRUE(Text("nan").toFloat(value));
+    TEST_ASSERT_FALSE(Text("ovf").toFloat(value));
+    TEST_ASSERT_FALSE(Text("7.25 ").toFloat(value));
+
+    long number;
+    TEST_ASSERT_TRUE(Text("-42").toLong(number));
+    TEST_ASSERT_EQUAL_INT32(-42, number);
+    TEST_ASSERT_FALSE(Text("4.2").toLong(number));
+}
+
+void test_parse_echo()
+{
+    Text command;
+    TEST_ASSERT_TRUE(Tester::parseEcho("-> The command received: \"ph calibrate start\"", command));
+    expectText("ph calibrate start", command);
+
+    TEST_ASSERT_FALSE(Tester::parseEcho("-> The command received: \"ph", command));
+    TEST_ASSERT_FALSE(Tester::parseEcho("-> The command received: \"", command));
+    TEST_ASSERT_FALSE(Tester::parseEcho("/ph 7.00", command));
+}
+
+void test_single_line_responses()
+{
+    TEST_ASSERT_TRUE(Tester::endsResponse("ph", "/ph 7.00"));
+    TEST_ASSERT_TRUE(Tester::endsResponse("ec calibrate get", "/ec calibration 1.00 2.00"));
+    TEST_ASSERT_FALSE(Tester::hasResponse("flush"));
+    TEST_ASSERT_TRUE(Tester::hasResponse("ph"));
+}
+
+void test_multi_line_responses()
+{
+    TEST_ASSERT_FALSE(Tester::endsResponse("ph calibrate start", "/ph calibration step 1"));
+    TEST_ASSERT_TRUE(Tester::endsResponse("ph calibrate start", "/ph calibration end"));
+
+    // either of the two last lines ends the profile dump
+    TEST_ASSERT_FALSE(Tester::endsResponse("stats prof", "/stats prof ph 12 us"));
+    TEST_ASSERT_TRUE(Tester::endsResponse("stats prof", "/stats prof end"));
+    TEST_ASSERT_TRUE(Tester::endsResponse("stats prof", "/stats prof disabled"));
+}
+
+void test_errors_end_every_response()
+{
+    TEST_ASSERT_TRUE(Tester::endsResponse("ph calibrate start", "/err: Calibration already running"));
+    TEST_ASSERT_TRUE(Tester::endsResponse("ph", "/err: Unknown command"));
+}
+
+void test_next_field_walks_the_record()
+{
+    Text record("/read {\"ph\": 7.01, \"ec\":1.50, \"temp1\": ovf}");
+    Text name;
+    Text value;
+
+    size_t pos = Tester::nextField(record, 0, name, value);
+    TEST_ASSERT_NOT_EQUAL(0, pos);
+    expectText("ph", name);
+    expectText("7.01", value);
+
+    pos = Tester::nextField(record, pos, name, value);
+    TEST_ASSERT_NOT_EQUAL(0, pos);
+    expectText("ec", name);
+    expectText("1.50", value);
+
+    pos = Tester::nextField(record, pos, name, value);
+    TEST_ASSERT_NOT_EQUAL(0, pos);
+    expectText("temp1", name);
+    expectText("ovf", value);
+
+    TEST_ASSERT_EQUAL_UINT32(0, Tester::nextField(record, pos, name, value));
+}
+
+void test_next_field_stops_at_malformed_fields()
+{
+    Text name;
+    Text value;
+
+    TEST_ASSERT_EQUAL_UINT32(0, Tester::nextField("/read {}", 0, name, value));
+    TEST_ASSERT_EQUAL_UINT32(0, Tester::nextField("/read {\"ph", 0, name, value));
+    TEST_ASSERT_EQUAL_UINT32(0, Tester::nextField("/read {\"ph\" 7.01}", 0, name, value));
+}
+
+void test_record_field()
+{
+    Text record("/read {\"ph\": 7.01, \"temp1\": ovf}");
+    float value;
+
+    TEST_ASSERT_TRUE(Tester::recordField(record, "ph", value));
+    TEST_ASSERT_EQUAL_FLOAT(7.01f, value);
+    TEST_ASSERT_FALSE(Tester::recordField(record, "temp1", value));
+    TEST_ASSERT_FALSE(Tester::recordField(record, "tds", value));
+}
+
+void test_frames_split_lines_and_packets()
+{
+    char input[64];
+    size_t size = 0;
+
+    const char line[] = "/ph 7.00\r\n";
+    memcpy(input, line, sizeof(line) - 1);
+    size += sizeof(line) - 1;
+
+    packet(reinterpret_cast<uint8_t *>(input + size), 2, 17, -3 * 65536);
+    size += Tester::PACKET_SIZE;
+
+    Tester::Frame frame;
+    size_t consumed = Tester::nextFrame(input, size, frame);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(line) - 1, consumed);
+    TEST_ASSERT_EQUAL_UINT8(Tester::Frame::LINE, frame.kind);
+    expectText("/ph 7.00", frame.line);
+
+    TEST_ASSERT_EQUAL_UINT32(Tester::PACKET_SIZE, Tester::nextFrame(input + consumed, size - consumed, frame));
+    TEST_ASSERT_EQUAL_UINT8(Tester::Frame::PACKET, frame.kind);
+    TEST_ASSERT_EQUAL_UINT8(2, frame.packet.channel);
+    TEST_ASSERT_EQUAL_UINT8(17, frame.packet.sequence);
+    TEST_ASSERT_EQUAL_FLOAT(-3.0f, frame.packet.value());
+}
+
+void test_frames_wait_for_complete_input()
+{
+    Tester::Frame frame;
+    TEST_ASSERT_EQUAL_UINT32(0, Tester::nextFrame("/ph 7.0", 7, frame));
+
+    uint8_t bytes[Tester::PACKET_SIZE];
+    packet(bytes, 0, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, Tester::nextFrame(reinterpret_cast<const char *>(bytes), 5, frame));
+}
+
+void test_frames_resync_after_corrupted_packets()
+{
+    char input[16];
+    packet(reinterpret_cast<uint8_t *>(input), 1, 1, 65536);
+    input[4] ^= 0x01;
+    memcpy(input + Tester::PACKET_SIZE, "/ok\n", 4);
+
+    // only the sync byte is skipped, the rest of the packet ends up in front of the line
+    Tester::Frame frame;
+    TEST_ASSERT_EQUAL_UINT32(Tester::PACKET_SIZE + 4, Tester::nextFrame(input, Tester::PACKET_SIZE + 4, frame));
+    TEST_ASSERT_EQUAL_UINT8(Tester::Frame::LINE, frame.kind);
+    TEST_ASSERT_EQUAL_UINT32(Tester::PACKET_SIZE - 1 + 3, frame.line.size);
+    expectText("/ok", frame.line.substr(frame.line.size - 3));
+}
+
+void test_long_lines_are_cut()
+{
+    static char input[Tester::MAX_LINE + 10];
+    memset(input, 'x', sizeof(input));
+
+    Tester::Frame frame;
+    TEST_ASSERT_EQUAL_UINT32(Tester::MAX_LINE, Tester::nextFrame(input, sizeof(input), frame));
+    TEST_ASSERT_EQUAL_UINT32(Tester::MAX_LINE, frame.line.size);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_text_words);
+    RUN_TEST(test_text_numbers);
+    RUN_TEST(test_parse_echo);
+    RUN_TEST(test_single_line_responses);
+    RUN_TEST(test_multi_line_responses);
+    RUN_TEST(test_errors_end_every_response);
+    RUN_TEST(test_next_field_walks_the_record);
+    RUN_TEST(test_next_field_stops_at_malformed_fields);
+    RUN_TEST(test_record_field);
+    RUN_TEST(test_frames_split_lines_and_packets);
+    RUN_TEST(test_frames_wait_for_complete_input);
+    RUN_TEST(test_frames_resync_after_corrupted_packets);
+    RUN_TEST(test_long_lines_are_cut);
+    return UNITY_END();
+}